@@ -0,0 +1,82 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/********************************************************************
+* RINGBUFFER CAPACITY BENCHMARK
+* usage: ./bench_capacity
+*
+* Fills a ring sized like the one in simpledaemon (1024 bytes) with
+* messages of a fixed size until it reports RINGBUFFER_FULL, once for
+* every length header, and prints how many messages were in flight.
+*
+* The second table compares daemon packets with the same payload:
+* the old layout with a size_t from/to/packet_id header behind a
+* size_t length prefix and the compact packet_header_t behind a u16
+* length prefix (the daemon's default).
+*********************************************************************/
+
+#define BENCH_RBUF_SIZE 1024
+#define BENCH_MAX_MESSAGE 128
+
+static const char *framing_names[] = {"size_t", "u16", "u32", "varint", "fixed"};
+
+static size_t capacity(rbframing_t framing, size_t message_len) {
+    rbctx_t ctx;
+    void *rbuf = malloc(BENCH_RBUF_SIZE);
+    if (rbuf == NULL) {
+        fprintf(stderr, "Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.framing = framing;
+    attr.slot_size = message_len; // RB_FRAME_FIXED record size
+    ringbuffer_init_attr(&ctx, rbuf, BENCH_RBUF_SIZE, &attr);
+
+    unsigned char msg[BENCH_MAX_MESSAGE];
+    memset(msg, 'x', sizeof(msg));
+    size_t n = 0;
+    while (ringbuffer_write_timed(&ctx, msg, message_len, RB_TIMEOUT_TRY) == SUCCESS) {
+        n++;
+    }
+
+    ringbuffer_destroy(&ctx);
+    free(rbuf);
+    return n;
+}
+
+int main(void) {
+    size_t sizes[] = {8, 16, 32, 64, 128};
+
+    printf("messages in flight in a %d byte ring\n", BENCH_RBUF_SIZE);
+    printf("%8s", "bytes");
+    for (int f = 0; f < 5; f++) {
+        printf("%11s", framing_names[f]);
+    }
+    printf("\n");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t base = capacity(RB_FRAME_SIZE_T, sizes[i]);
+        printf("%8zu", sizes[i]);
+        for (int f = 0; f < 5; f++) {
+            size_t n = capacity((rbframing_t) f, sizes[i]);
+            printf("%6zu%+5.0f%%", n, 100.0 * ((double) n - base) / base);
+        }
+        printf("\n");
+    }
+
+    /* the largest payload is what the daemon reads from a file per packet */
+    size_t old_header = 3 * sizeof(size_t);
+    size_t new_header = 2 * sizeof(uint16_t) + sizeof(uint32_t);
+    size_t payloads[] = {16, 64, BENCH_MAX_MESSAGE - old_header};
+    printf("\ndaemon packets in flight (payload bytes in flight)\n");
+    printf("%8s%20s%20s\n", "payload", "size_t + 24 bytes", "u16 + 8 bytes");
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+        size_t old_n = capacity(RB_FRAME_SIZE_T, payloads[i] + old_header);
+        size_t new_n = capacity(RB_FRAME_U16, payloads[i] + new_header);
+        printf("%8zu%10zu (%5zu)%10zu (%5zu)\n", payloads[i],
+               old_n, old_n * payloads[i], new_n, new_n * payloads[i]);
+    }
+    return 0;
+}
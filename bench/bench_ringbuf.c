@@ -0,0 +1,190 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+/********************************************************************
+* RINGBUFFER BENCHMARK
+* usage: ./bench_ringbuf [messages] [writers] [readers] [mode]
+* mode is one of: locked (default), combining, spsc, mpmc, twolock
+* (combining is locked with rbattr_t.combining set)
+*
+* Part 1 measures the uncontended cost of a single write and read
+* call. Without contention this is almost exactly the time the
+* call holds context->mtx, so it is used as the lock hold time.
+*
+* Part 2 runs writers and readers concurrently on a ring sized like
+* the one in simpledaemon (1024 bytes, 128 byte packets) and reports
+* the achieved throughput in messages per second. Built with
+* HISTOGRAMS=1 it also prints the latency percentiles of that run.
+*
+* Part 3 repeats part 2 with 8, 32 and 128 writers and one reader,
+* the fan-in of simpledaemon with one writer thread per connection
+* (not for spsc).
+*********************************************************************/
+
+#define BENCH_MESSAGE_SIZE 128
+#define BENCH_RBUF_SIZE 1024
+
+static rbattr_t bench_attr;
+
+typedef struct {
+    rbctx_t *ctx;
+    size_t count;
+} bench_args_t;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *bench_writer(void *arg) {
+    bench_args_t *args = arg;
+    unsigned char msg[BENCH_MESSAGE_SIZE];
+    memset(msg, 'x', sizeof(msg));
+
+    for (size_t i = 0; i < args->count; i++) {
+        while (ringbuffer_write(args->ctx, msg, sizeof(msg)) != SUCCESS);
+    }
+    return NULL;
+}
+
+static void *bench_reader(void *arg) {
+    bench_args_t *args = arg;
+    unsigned char buf[BENCH_MESSAGE_SIZE];
+
+    for (size_t i = 0; i < args->count; i++) {
+        size_t len = sizeof(buf);
+        while (ringbuffer_read(args->ctx, buf, &len) != SUCCESS) {
+            len = sizeof(buf);
+        }
+    }
+    return NULL;
+}
+
+static void bench_uncontended(size_t messages) {
+    rbctx_t ctx;
+    void *rbuf = malloc(BENCH_RBUF_SIZE);
+    if (rbuf == NULL) {
+        fprintf(stderr, "Error: malloc failed\n");
+        exit(1);
+    }
+    ringbuffer_init_attr(&ctx, rbuf, BENCH_RBUF_SIZE, &bench_attr);
+
+    unsigned char msg[BENCH_MESSAGE_SIZE];
+    memset(msg, 'x', sizeof(msg));
+    double write_time = 0, read_time = 0;
+
+    for (size_t i = 0; i < messages; i++) {
+        double start = now_sec();
+        ringbuffer_write(&ctx, msg, sizeof(msg));
+        double mid = now_sec();
+        size_t len = sizeof(msg);
+        ringbuffer_read(&ctx, msg, &len);
+        double end = now_sec();
+        write_time += mid - start;
+        read_time += end - mid;
+    }
+
+    printf("uncontended: write %.1f ns/op, read %.1f ns/op\n",
+           write_time / messages * 1e9, read_time / messages * 1e9);
+
+    ringbuffer_destroy(&ctx);
+    free(rbuf);
+}
+
+/* prints the histograms of ctx, nothing without RBUF_HISTOGRAMS */
+static void print_histograms(rbctx_t *ctx) {
+    const char *names[] = {"lock hold", "wait", "residency"};
+    for (int kind = 0; kind < RB_HIST_KINDS; kind++) {
+        rbhist_summary_t h;
+        if (ringbuffer_get_histogram(ctx, (rbhist_kind_t) kind, &h) != SUCCESS) {
+            return;
+        }
+        printf("  %-10s n=%-9llu p50 %8llu ns  p99 %8llu ns  p99.9 %8llu ns  max %8llu ns\n", names[kind],
+               (unsigned long long) h.count, (unsigned long long) h.p50, (unsigned long long) h.p99,
+               (unsigned long long) h.p999, (unsigned long long) h.max);
+    }
+}
+
+static void bench_contended(size_t messages, int writers, int readers) {
+    rbctx_t ctx;
+    void *rbuf = malloc(BENCH_RBUF_SIZE);
+    if (rbuf == NULL) {
+        fprintf(stderr, "Error: malloc failed\n");
+        exit(1);
+    }
+    ringbuffer_init_attr(&ctx, rbuf, BENCH_RBUF_SIZE, &bench_attr);
+
+    /* every reader takes the same share, so total must be divisible */
+    size_t total = messages - messages % ((size_t) writers * readers);
+    bench_args_t w_args = {&ctx, total / writers};
+    bench_args_t r_args = {&ctx, total / readers};
+
+    pthread_t w_threads[writers];
+    pthread_t r_threads[readers];
+    double start = now_sec();
+    for (int i = 0; i < writers; i++) {
+        pthread_create(&w_threads[i], NULL, bench_writer, &w_args);
+    }
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&r_threads[i], NULL, bench_reader, &r_args);
+    }
+    for (int i = 0; i < writers; i++) {
+        pthread_join(w_threads[i], NULL);
+    }
+    for (int i = 0; i < readers; i++) {
+        pthread_join(r_threads[i], NULL);
+    }
+    double elapsed = now_sec() - start;
+
+    printf("contended (%d writers, %d readers): %.0f msgs/s\n",
+           writers, readers, total / elapsed);
+    print_histograms(&ctx);
+
+    ringbuffer_destroy(&ctx);
+    free(rbuf);
+}
+
+int main(int argc, char *argv[]) {
+    size_t messages = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    int writers = argc > 2 ? atoi(argv[2]) : 3;
+    int readers = argc > 3 ? atoi(argv[3]) : 4;
+
+    const char *mode = argc > 4 ? argv[4] : "locked";
+
+    ringbuffer_attr_init(&bench_attr);
+    if (strcmp(mode, "spsc") == 0) {
+        bench_attr.mode = RB_MODE_SPSC;
+        writers = readers = 1;
+    } else if (strcmp(mode, "mpmc") == 0) {
+        bench_attr.mode = RB_MODE_MPMC;
+        bench_attr.slot_size = BENCH_MESSAGE_SIZE;
+    } else if (strcmp(mode, "combining") == 0) {
+        bench_attr.combining = 1;
+    } else if (strcmp(mode, "twolock") == 0) {
+        bench_attr.mode = RB_MODE_TWOLOCK;
+    } else if (strcmp(mode, "locked") != 0) {
+        messages = 0;
+    }
+
+    if (messages == 0 || writers <= 0 || readers <= 0) {
+        fprintf(stderr, "usage: %s [messages] [writers] [readers] [locked|combining|spsc|mpmc|twolock]\n", argv[0]);
+        return 1;
+    }
+
+    printf("mode: %s\n", mode);
+
+    bench_uncontended(messages);
+    bench_contended(messages, writers, readers);
+    if (bench_attr.mode != RB_MODE_SPSC) {
+        const int fan_in[] = {8, 32, 128};
+        for (size_t i = 0; i < sizeof(fan_in) / sizeof(fan_in[0]); i++) {
+            bench_contended(messages, fan_in[i], 1);
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,8 @@
 #ifndef DAEMON_H
 #define DAEMON_H
 
+#include <stdint.h>
+
 typedef struct {
     int from;
     int to;
@@ -11,6 +13,39 @@ typedef struct {
 #define MINIMUM_PORT 0          /* this will always be 0 */
 #define MAXIMUM_PORT 128
 #define NUMBER_OF_PROCESSING_THREADS 4
+#define READ_BATCH_SIZE 8       /* packets a processing thread takes per ringbuffer read */
+#define READ_POLL_TIMEOUT_MS 10 /* longest a processing thread waits on the ringbuffer's data fd */
+#define DAEMON_RING_MAX_SIZE 65536 /* largest the locked ringbuffer of simpledaemon grows to */
+
+/* ringbuffer mode used by simpledaemon (RB_MODE_LOCKED, RB_MODE_MPMC or RB_MODE_TWOLOCK),
+ * select with e.g. make RING_MODE=RB_MODE_MPMC */
+#ifndef DAEMON_RING_MODE
+#define DAEMON_RING_MODE RB_MODE_LOCKED
+#endif
+
+/* length header of the ringbuffer frames, packets never exceed MESSAGE_SIZE so
+ * two bytes are enough, select with e.g. make RING_FRAMING=RB_FRAME_VARINT.
+ * RB_FRAME_FIXED carries no packet length and is rejected by daemon.c */
+#ifndef DAEMON_RING_FRAMING
+#define DAEMON_RING_FRAMING RB_FRAME_U16
+#endif
+
+/* 1 lets the write_packets thread holding the ringbuffer mutex write the packets of the
+ * others too (rbattr_t.combining, RB_MODE_LOCKED only), select with make RING_COMBINING=1 */
+#ifndef DAEMON_RING_COMBINING
+#define DAEMON_RING_COMBINING 0
+#endif
+
+/* header in front of every packet in the ringbuffer, ports never exceed MAXIMUM_PORT */
+typedef struct {
+    uint32_t packet_id;
+    uint16_t from;
+    uint16_t to;
+} packet_header_t;
+
+/* file bytes per packet, unchanged from the former 3 * size_t header so that the
+ * firewall sees the same packets; the compact header leaves the rest of MESSAGE_SIZE free */
+#define PACKET_PAYLOAD_SIZE (MESSAGE_SIZE - 3 * sizeof(size_t))
 
 /**
  * @brief simpledaemon
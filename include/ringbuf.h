@@ -8,6 +8,19 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/uio.h>
+
+// the shared types are usable from C++ (see ringbuf_channel.hpp), with the same layout
+#ifdef __cplusplus
+#include <atomic>
+#define RB_ATOMIC(T) std::atomic<T>
+#define RB_ALIGNAS(n) alignas(n)
+extern "C" {
+#else
+#include <stdatomic.h>
+#define RB_ATOMIC(T) _Atomic(T)
+#define RB_ALIGNAS(n) _Alignas(n)
+#endif
 
 #define SUCCESS 0
 #define RINGBUFFER_FULL 1
@@ -16,15 +29,245 @@
 
 #define RBUF_TIMEOUT 1
 
+// timeouts of the *_timed functions, in nanoseconds
+#define RB_TIMEOUT_TRY 0                                  // never wait
+#define RB_TIMEOUT_INFINITE ((int64_t) -1)                // wait until the operation succeeds
+#define RB_TIMEOUT_DEFAULT ((int64_t) RBUF_TIMEOUT * 1000000000) // used by the functions without a timeout
+
+#define RB_CACHE_LINE 64
+#define RB_DEFAULT_SLOT_SIZE 128
+
+typedef enum {
+    RB_MODE_LOCKED = 0, // mutex + condition variable, any number of writers and readers
+    RB_MODE_SPSC,       // lock-free, exactly one writer thread and one reader thread
+    RB_MODE_MPMC,       // lock-free, fixed-size slots, any number of writers and readers
+    RB_MODE_TWOLOCK,    // one lock for writers and one for readers, any number of each
+} rbmode_t;
+
+typedef enum {
+    RB_WAIT_DEFAULT = 0, // RB_WAIT_CONDVAR in RB_MODE_LOCKED and RB_MODE_TWOLOCK, RB_WAIT_SPIN_YIELD in the lock-free modes
+    RB_WAIT_CONDVAR,     // sleep on a condition variable
+    RB_WAIT_SPIN,        // busy-spin, lowest wakeup latency, burns a core while waiting
+    RB_WAIT_SPIN_YIELD,  // spin for a short while, then sched_yield between checks
+    RB_WAIT_FUTEX,       // spin for a short while, then park on a futex (condition variable outside Linux)
+} rbwait_t;
+
+typedef enum {
+    RB_FRAME_SIZE_T = 0, // size_t length prefix in front of every message
+    RB_FRAME_U16,        // 2-byte length prefix, messages up to UINT16_MAX bytes
+    RB_FRAME_U32,        // 4-byte length prefix, messages up to UINT32_MAX bytes
+    RB_FRAME_VARINT,     // LEB128 length prefix: 1 byte up to 127 bytes, 2 bytes up to 16383 bytes
+    RB_FRAME_FIXED,      // no prefix, every message occupies a record of slot_size bytes
+} rbframing_t;
+
 typedef struct {
-    uint8_t* read;
-    uint8_t* write;
+    rbmode_t mode;
+    size_t slot_size;    // RB_MODE_MPMC: largest message a slot can hold, RB_FRAME_FIXED: record size
+    rbwait_t wait;       // how writers wait for space and readers wait for data
+    rbframing_t framing; // length header of RB_MODE_LOCKED and RB_MODE_SPSC (MPMC slots keep their own)
+    int overwrite;       // RB_MODE_LOCKED: writers drop the oldest messages instead of waiting for space
+    int combining;       // RB_MODE_LOCKED: the writer holding the mutex also applies the writes of those waiting for it
+} rbattr_t;
+
+/*
+ * Something a writer or reader can wait for. seq is bumped on every notification,
+ * waiters counts the threads parked on it so notifiers can skip the wakeup otherwise.
+ * With ringbuffer_enable_poll the event also has an eventfd, signaled by the first
+ * notification after a caller armed it.
+ */
+typedef struct {
+    RB_ATOMIC(uint32_t) seq;
+    RB_ATOMIC(uint32_t) waiters;
+    int fd;                 // eventfd, -1 unless ringbuffer_enable_poll was called
+    RB_ATOMIC(uint32_t) armed; // set by a caller that is about to poll fd, cleared by the notifier that signals it
+} rbevent_t;
+
+/*
+ * Counters of one side of the ring, kept with relaxed atomics. Writers and readers
+ * update separate cache lines.
+ */
+typedef struct {
+    RB_ATOMIC(uint64_t) messages;
+    RB_ATOMIC(uint64_t) bytes;
+    RB_ATOMIC(uint64_t) timeouts;   // writes that returned RINGBUFFER_FULL, reads RINGBUFFER_EMPTY
+    RB_ATOMIC(uint64_t) too_small;  // calls that returned OUTPUT_BUFFER_TOO_SMALL
+    RB_ATOMIC(uint64_t) wait_ns;    // time spent waiting for space or data
+    RB_ATOMIC(uint64_t) high_water; // writers only: most bytes in use right after a write
+    RB_ATOMIC(uint64_t) resizes;    // RB_STORAGE_HEAP: writers count grows, readers shrinks
+    RB_ATOMIC(uint64_t) dropped;    // writers only: messages dropped to make room in an overwrite ring
+} rbcounters_t;
+
+/*
+ * Snapshot returned by ringbuffer_get_stats.
+ */
+typedef struct {
+    uint64_t messages_written;
+    uint64_t bytes_written;      // message bytes, without length headers
+    uint64_t messages_read;
+    uint64_t bytes_read;
+    uint64_t full_timeouts;      // writes that returned RINGBUFFER_FULL
+    uint64_t empty_timeouts;     // reads that returned RINGBUFFER_EMPTY
+    uint64_t too_small;          // calls that returned OUTPUT_BUFFER_TOO_SMALL
+    uint64_t high_water;         // most bytes in use at once, headers included (MPMC: slots * slot_stride)
+    uint64_t write_wait_ns;      // time writers spent waiting for space
+    uint64_t read_wait_ns;       // time readers spent waiting for data
+    uint64_t grows;              // RB_STORAGE_HEAP: times the ring was enlarged
+    uint64_t shrinks;            // RB_STORAGE_HEAP: times the ring was made smaller
+    uint64_t dropped;            // messages an overwrite ring dropped unread
+} rbstats_t;
+
+typedef enum {
+    RB_HIST_LOCK_HOLD = 0, // RB_MODE_LOCKED: how long a caller holds mtx, from its last acquisition to unlock
+    RB_HIST_WAIT,          // how long a writer waited for space or a reader for data, if it had to wait
+    RB_HIST_RESIDENCY,     // how long a message stayed in the ring between write and read
+    RB_HIST_KINDS,
+} rbhist_kind_t;
+
+/*
+ * Percentiles returned by ringbuffer_get_histogram, in nanoseconds. A percentile is the
+ * highest value of its bucket, at most 1/16 (6.25%) above the recorded value.
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+} rbhist_summary_t;
+
+#ifdef RBUF_HISTOGRAMS
+/*
+ * Log-linear histogram of nanosecond values with fixed memory: values below 16 get a
+ * bucket each, every power of two above is split into 16 buckets.
+ */
+#define RB_HIST_SUB_BITS 4
+#define RB_HIST_BUCKETS ((64 - RB_HIST_SUB_BITS + 1) << RB_HIST_SUB_BITS)
+// write timestamps kept for RB_HIST_RESIDENCY, messages beyond that many in flight are not sampled
+#define RB_HIST_STAMPS 1024
+
+typedef struct {
+    RB_ATOMIC(uint64_t) max;
+    RB_ATOMIC(uint64_t) buckets[RB_HIST_BUCKETS];
+} rbhist_t;
+#endif
+
+typedef enum {
+    RB_STORAGE_USER = 0, // buffer passed in by the caller, never freed by the ringbuffer
+    RB_STORAGE_MIRRORED, // buffer mapped twice back to back by ringbuffer_init_mirrored
+    RB_STORAGE_SHARED,   // shared memory object mapped by ringbuffer_create_shared/ringbuffer_attach_shared
+    RB_STORAGE_HEAP,     // malloc'ed by ringbuffer_init_resizable, replaced whenever the ring is resized
+    RB_STORAGE_MAPPED,   // anonymous mapping made by ringbuffer_create
+} rbstorage_t;
+
+#define RB_HUGE_PAGE_SIZE ((size_t) 2 << 20) // huge page size assumed when rbmem_t.huge_page_size is 0
+
+typedef enum {
+    RB_PAGES_DEFAULT = 0, // base pages
+    RB_PAGES_TRANSPARENT, // huge page aligned mapping with MADV_HUGEPAGE, base pages if the kernel has none to spare
+    RB_PAGES_HUGETLB,     // MAP_HUGETLB, fails unless enough huge pages are reserved
+} rbpages_t;
+
+/*
+ * How ringbuffer_create allocates the memory of a ring.
+ */
+typedef struct {
+    rbpages_t pages;
+    size_t huge_page_size; // RB_PAGES_TRANSPARENT and RB_PAGES_HUGETLB: 0 for RB_HUGE_PAGE_SIZE
+    int prefault;          // touch every page before returning, so no write faults one in later
+    int lock;              // mlock the memory, it is never swapped out
+    int numa_node;         // bind the memory to this NUMA node, -1 for the default policy
+} rbmem_t;
+
+/*
+ * Called after a resizable ring changed its size, with the ring locked: it must not
+ * call back into the ring.
+ */
+typedef void (*rbresize_cb_t)(void *arg, size_t old_size, size_t new_size);
+
+/*
+ * When a ringbuffer_init_resizable ring changes its size. The occupancy is checked
+ * whenever a caller unlocks the ring.
+ */
+typedef struct {
+    size_t min_size;       // never shrink below, 0 for the initial size
+    size_t max_size;       // never grow beyond, 0 for 64 times the initial size
+    unsigned grow_at;      // percent of the ring in use at which an unlock counts as busy
+    unsigned grow_after;   // busy unlocks in a row that double the ring
+    unsigned shrink_at;    // percent of the ring in use below which an unlock counts as idle
+    unsigned shrink_after; // idle unlocks in a row that halve the ring
+    rbresize_cb_t on_resize; // optional
+    void *arg;             // passed to on_resize
+} rbresize_t;
+
+// state of a process-shared ring, at the start of its shared memory object (see ringbuf.c)
+struct rbshared;
+
+// a write posted to the lock holder of a combining ring, on the stack of its writer (see ringbuf.c)
+struct rbcombine;
+
+typedef struct {
+    uint8_t* read;  // only maintained in RB_MODE_LOCKED
+    uint8_t* write; // only maintained in RB_MODE_LOCKED
     uint8_t* begin;
     uint8_t* end; //1 step AFTER the last readable address
     pthread_mutex_t mtx;
-    pthread_cond_t sig;
+    pthread_cond_t sig;   // readers wait here for data
+    pthread_cond_t space; // writers wait here for space
+    pthread_mutex_t *lock;       // &mtx, or the process-shared mutex of a shared ring
+    pthread_cond_t *data_cond;   // &sig, likewise
+    pthread_cond_t *space_cond;  // &space, likewise
+    struct rbshared *shared;     // RB_STORAGE_SHARED: the mapped object, read/write are synced with it
+    rbevent_t data_event;  // notified when a message is published
+    rbevent_t space_event; // notified when a message is consumed
+    rbmode_t mode;
+    rbwait_t wait;
+    rbframing_t framing;
+    int overwrite;       // RB_MODE_LOCKED: writers drop the oldest messages when the ring is full
+    uint64_t read_seq;   // RB_MODE_LOCKED: number of the next message to read, counting dropped ones
+    int combining;       // RB_MODE_LOCKED: writes are posted to combine_list and applied by the lock holder
+    size_t mask;         // RB_MODE_SPSC/TWOLOCK: capacity - 1, the capacity is a power of two
+    // consumer cursor, on its own cache line with what only the consumer touches
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(size_t) head; // RB_MODE_SPSC/TWOLOCK: bytes read so far, RB_MODE_MPMC: next slot to dequeue
+    size_t tail_cache;   // RB_MODE_SPSC/TWOLOCK: the consumer's last view of tail
+    pthread_mutex_t read_mtx;  // RB_MODE_TWOLOCK: serializes readers
+    // producer cursor, likewise
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(size_t) tail; // RB_MODE_SPSC/TWOLOCK: bytes written so far, RB_MODE_MPMC: next slot to enqueue
+    size_t head_cache;   // RB_MODE_SPSC/TWOLOCK: the producer's last view of head
+    pthread_mutex_t write_mtx; // RB_MODE_TWOLOCK: serializes writers
+    RB_ATOMIC(struct rbcombine *) combine_list; // combining: posted writes, newest first
+    RB_ALIGNAS(RB_CACHE_LINE) uint8_t* slots; // RB_MODE_MPMC: first cache-line-aligned slot
+    size_t slot_size;    // RB_MODE_MPMC: payload bytes per slot, RB_FRAME_FIXED: record size
+    size_t slot_stride;  // RB_MODE_MPMC: distance between slots, a multiple of RB_CACHE_LINE
+    size_t slot_count;   // RB_MODE_MPMC: number of slots that fit into the buffer
+    rbstorage_t storage; // who owns [begin, end) and how ringbuffer_destroy releases it
+    rbresize_t resize;   // RB_STORAGE_HEAP: bounds and policy, sizes resolved
+    unsigned busy_unlocks; // RB_STORAGE_HEAP: unlocks in a row at or above resize.grow_at
+    unsigned idle_unlocks; // RB_STORAGE_HEAP: unlocks in a row below resize.shrink_at
+    size_t map_size;     // RB_STORAGE_MAPPED: length of the mapping at begin
+    RB_ALIGNAS(RB_CACHE_LINE) rbcounters_t write_stats;
+    RB_ALIGNAS(RB_CACHE_LINE) rbcounters_t read_stats;
+#ifdef RBUF_HISTOGRAMS
+    rbhist_t hist[RB_HIST_KINDS];
+    // side-ring of write timestamps, entry i belongs to the i-th message written (MPMC: position i)
+    RB_ATOMIC(uint64_t) stamps[RB_HIST_STAMPS];
+    uint64_t locked_at;    // RB_MODE_LOCKED: when the current holder of mtx got it
+    RB_ALIGNAS(RB_CACHE_LINE) size_t stamps_written; // RB_MODE_LOCKED, SPSC and TWOLOCK: messages written so far
+    RB_ALIGNAS(RB_CACHE_LINE) size_t stamps_read;    // RB_MODE_LOCKED, SPSC and TWOLOCK: messages read so far
+#endif
 } rbctx_t;
 
+/*
+ * A message area inside the ring. When the area wraps around the end of the buffer
+ * it is split into ptr[0]/len[0] and ptr[1]/len[1], otherwise ptr[1] is NULL.
+ * Mirrored rings never split: ptr[0] may then run past end into the second mapping.
+ */
+typedef struct {
+    uint8_t* ptr[2];
+    size_t len[2];
+    uint8_t* frame; // internal: start of the frame (reserve) or of the next frame (peek), MPMC slot
+    size_t pos;     // internal: RB_MODE_SPSC/TWOLOCK cursor behind the frame, RB_MODE_MPMC position
+} rbspan_t;
+
 /**
  * Initialize a thread-safe lock-free ringbuffer.
  * Generate ringbuffer context and memory before initialization.
@@ -35,6 +278,164 @@ typedef struct {
  */
 void ringbuffer_init(rbctx_t *context, void *buffer_location, size_t buffer_size);
 
+/**
+ * Initialize a ringbuffer attribute object with the defaults used by ringbuffer_init.
+ *
+ * @param attr attributes to initialize
+ */
+void ringbuffer_attr_init(rbattr_t *attr);
+
+/**
+ * Initialize a ringbuffer with explicit attributes.
+ * RB_MODE_SPSC keeps the same length-prefixed framing as RB_MODE_LOCKED but publishes
+ * head and tail with acquire/release atomics and never takes the mutex, so it must only
+ * be used by exactly one writer thread and one reader thread. head and tail only ever
+ * grow, the ring uses the largest power of two <= buffer_size bytes and every one of
+ * them can hold data (occupancy is tail - head, offsets are cursor & mask).
+ * RB_MODE_TWOLOCK runs the same cursors for any number of writers and readers: writers
+ * serialize on one mutex and readers on another, like the Michael-Scott two-lock queue,
+ * so the two sides only share head and tail and never wait for each other's lock.
+ * RB_MODE_MPMC splits the buffer into cache-line-aligned slots of attr->slot_size bytes.
+ * Every slot carries a sequence number, writers and readers claim slots with a CAS on
+ * tail/head and never share a lock. Messages larger than a slot are rejected with
+ * RINGBUFFER_FULL.
+ * attr->wait selects how a blocked writer or reader waits in every mode. Writers and
+ * readers wait on separate conditions, so a write only ever wakes readers and a read
+ * only ever wakes writers.
+ * attr->framing selects the length header of the byte-ring modes. The compact headers
+ * fit more messages into the same memory; messages longer than the header can describe
+ * are rejected with RINGBUFFER_FULL. With RB_FRAME_FIXED there is no header at all:
+ * shorter messages are zero-padded to slot_size bytes and every read returns slot_size bytes.
+ * attr->overwrite turns a RB_MODE_LOCKED ring into a lossy one: a write that finds the
+ * ring full drops whole messages, oldest first, until its own fits, so writers never wait
+ * for readers (only for the mutex). Dropped messages are counted in ringbuffer_get_stats,
+ * readers see the gap in the numbers returned by ringbuffer_read_seq. The lock-free
+ * modes ignore it.
+ * attr->combining makes a RB_MODE_LOCKED ring combine writes (flat combining): a writer
+ * posts its message to a list and whichever writer gets the mutex copies every posted
+ * message in one critical section, with one wakeup for the readers. Under many writers
+ * the mutex then changes hands once per batch instead of once per message. A posted
+ * message that does not fit right away goes back to its writer, which then waits for
+ * space as usual. Only ringbuffer_write and ringbuffer_write_timed combine.
+ *
+ * @param context ringbuffer context.
+ * @param buffer_location the first byte location of the ringbuffer in memory
+ * @param buffer_size size of the ringbuffer (and memory)
+ * @param attr ringbuffer attributes, NULL for the defaults
+ */
+void ringbuffer_init_attr(rbctx_t *context, void *buffer_location, size_t buffer_size, const rbattr_t *attr);
+
+/**
+ * Initialize a ringbuffer whose memory is allocated by the ringbuffer itself and mapped
+ * twice, back to back, so that begin[i] and end[i] are the same byte. Length prefixes and
+ * messages are then always copied with one memcpy and every reserved or peeked span is
+ * contiguous (ptr[1] is always NULL), even when it wraps around end.
+ * ringbuffer_destroy unmaps the memory.
+ *
+ * @param context ringbuffer context.
+ * @param buffer_size requested size of the ringbuffer, rounded up to a power-of-two number of pages
+ * @param attr ringbuffer attributes, NULL for the defaults
+ * @return SUCCESS, or an errno value if the memory could not be mapped
+ */
+int ringbuffer_init_mirrored(rbctx_t *context, size_t buffer_size, const rbattr_t *attr);
+
+/**
+ * Initialize memory options with the defaults: base pages, faulted in on first touch,
+ * not locked, default NUMA policy.
+ *
+ * @param mem options to initialize
+ */
+void ringbuffer_mem_init(rbmem_t *mem);
+
+/**
+ * Initialize a ringbuffer whose memory is an anonymous mapping made by the ringbuffer
+ * itself. The memory is bound to mem->numa_node before any page of it is touched, then
+ * prefaulted and locked if asked for, so large rings get their pages, on the right node,
+ * up front instead of on the first lap. ringbuffer_destroy unlocks and unmaps it.
+ *
+ * @param context ringbuffer context.
+ * @param buffer_size requested size of the ringbuffer, rounded up to whole pages (huge pages
+ *        with RB_PAGES_TRANSPARENT and RB_PAGES_HUGETLB), and to a power of two in RB_MODE_SPSC and RB_MODE_TWOLOCK
+ * @param attr ringbuffer attributes, NULL for the defaults
+ * @param mem memory options, NULL for the defaults
+ * @return SUCCESS, EINVAL for a bad option, ENOSYS if NUMA binding is not supported, or the errno value of the mmap, mbind or mlock that failed
+ */
+int ringbuffer_create(rbctx_t *context, size_t buffer_size, const rbattr_t *attr, const rbmem_t *mem);
+
+/**
+ * Initialize a resize policy with the defaults: double the ring after 8 unlocks in a row
+ * found it at least 75% full, halve it after 1024 unlocks in a row found it less than
+ * 25% full, between the initial size and 64 times that.
+ *
+ * @param policy policy to initialize
+ */
+void ringbuffer_resize_init(rbresize_t *policy);
+
+/**
+ * Initialize a RB_MODE_LOCKED ringbuffer whose memory is allocated by the ringbuffer and
+ * resized online. Besides following policy, a writer that finds the ring full grows it
+ * right away (up to max_size) instead of waiting. A resize copies the messages in the
+ * ring, oldest first, to the start of a new buffer with the mutex held, so none are
+ * lost or reordered. Only the locked mode can be resized, attr->mode is ignored.
+ * Resizes are counted in ringbuffer_get_stats and reported to policy->on_resize.
+ * ringbuffer_destroy frees the memory.
+ *
+ * @param context ringbuffer context.
+ * @param buffer_size initial size of the ringbuffer
+ * @param attr ringbuffer attributes, NULL for the defaults
+ * @param policy when to grow and shrink, NULL for the defaults
+ * @return SUCCESS, ENOMEM, or EINVAL if the bounds do not include buffer_size
+ */
+int ringbuffer_init_resizable(rbctx_t *context, size_t buffer_size, const rbattr_t *attr, const rbresize_t *policy);
+
+/**
+ * Resize a ringbuffer_init_resizable ring now.
+ *
+ * @param context ringbuffer context
+ * @param buffer_size new size, within the bounds of the policy
+ * @return SUCCESS, ENOMEM, EBUSY if the messages in the ring do not fit, EINVAL if the ring is not resizable or buffer_size is out of bounds
+ */
+int ringbuffer_resize(rbctx_t *context, size_t buffer_size);
+
+/**
+ * Create a RB_MODE_LOCKED ringbuffer in a new POSIX shared memory object that other
+ * processes can open with ringbuffer_attach_shared. The object starts with a header that
+ * holds the read and write positions as offsets, a robust process-shared mutex and
+ * process-shared condition variables, so every process may map it at its own address.
+ * Positions are only published when a caller unlocks the ring: if a process dies while
+ * holding the lock, the next caller takes the lock over and finds the ring as it was
+ * before that operation started, except that an overwrite ring has lost the messages
+ * the dead writer already dropped to make room.
+ * Only the locked mode can be shared and writers and readers always wait on the condition
+ * variables, attr->mode and attr->wait are ignored. Statistics and histograms are kept
+ * per process. ringbuffer_destroy unmaps the object, ringbuffer_unlink_shared removes it.
+ *
+ * @param context ringbuffer context of this process
+ * @param name name of the shared memory object, "/something"
+ * @param buffer_size size of the ringbuffer, the object is a header larger
+ * @param attr ringbuffer attributes (framing and slot_size), NULL for the defaults
+ * @return SUCCESS, or an errno value (EEXIST if the object already exists)
+ */
+int ringbuffer_create_shared(rbctx_t *context, const char *name, size_t buffer_size, const rbattr_t *attr);
+
+/**
+ * Open a ringbuffer created by ringbuffer_create_shared, possibly in another process.
+ *
+ * @param context ringbuffer context of this process
+ * @param name name passed to ringbuffer_create_shared
+ * @return SUCCESS, or an errno value (EINVAL if the object is not a ringbuffer or not initialized yet)
+ */
+int ringbuffer_attach_shared(rbctx_t *context, const char *name);
+
+/**
+ * Remove the name of a shared ringbuffer. Processes that are attached keep using it,
+ * the memory is freed once the last of them calls ringbuffer_destroy.
+ *
+ * @param name name passed to ringbuffer_create_shared
+ * @return SUCCESS, or an errno value
+ */
+int ringbuffer_unlink_shared(const char *name);
+
 /**
  * Write to the ringbuffer.
  * 
@@ -55,6 +456,306 @@ int ringbuffer_write(rbctx_t *context, void *message, size_t message_len);
  */
 int ringbuffer_read(rbctx_t *context, void *buffer, size_t *buffer_len_ptr);
 
+/**
+ * Write to the ringbuffer, waiting at most timeout_ns for space.
+ * ringbuffer_write is ringbuffer_write_timed with RB_TIMEOUT_DEFAULT.
+ *
+ * @param context ringbuffer context
+ * @param message message to be stored
+ * @param message_len length of message to be stored in bytes
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS on success, RINGBUFFER_FULL if the ring stayed full
+ */
+int ringbuffer_write_timed(rbctx_t *context, void *message, size_t message_len, int64_t timeout_ns);
+
+/**
+ * Read from the ringbuffer, waiting at most timeout_ns for data.
+ * ringbuffer_read is ringbuffer_read_timed with RB_TIMEOUT_DEFAULT.
+ *
+ * @param context ringbuffer context
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received from ringbuffer is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS on succes, RINGBUFFER_EMPTY if the ring stayed empty, OUTPUT_BUFFER_TOO_SMALL when read message doesn't fit
+ */
+int ringbuffer_read_timed(rbctx_t *context, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns);
+
+/**
+ * Read like ringbuffer_read_timed and return the number of the message as well.
+ * Messages are numbered from 0 in the order they were written, so a reader of an
+ * overwrite ring finds the number of messages dropped before this one in the gap to
+ * the number it read last.
+ *
+ * @param context ringbuffer context
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received from ringbuffer is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @param seq number of the message received is stored here
+ * @return like ringbuffer_read_timed, ENOTSUP in the lock-free modes
+ */
+int ringbuffer_read_seq(rbctx_t *context, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns, uint64_t *seq);
+
+/**
+ * Read up to max_messages messages in a single critical section.
+ * Waits like ringbuffer_read for the first message, then takes whatever else is ready.
+ * The batch stops early at a message that does not fit its buffer or would exceed
+ * max_bytes; such a message stays in the ring for the next call.
+ *
+ * @param context ringbuffer context
+ * @param buffers max_messages output buffers
+ * @param buffer_lens sizes of the output buffers. Sizes of the messages received are stored here
+ * @param max_messages maximum number of messages to read
+ * @param max_bytes byte budget for the whole batch, 0 for no limit (the first message is always read)
+ * @param count number of messages read is stored here
+ * @return SUCCESS if at least one message was read, RINGBUFFER_EMPTY if no data to read, OUTPUT_BUFFER_TOO_SMALL when the first message doesn't fit buffers[0]
+ */
+int ringbuffer_read_batch(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                          size_t max_messages, size_t max_bytes, size_t *count);
+
+/**
+ * Like ringbuffer_read_batch, waiting at most timeout_ns for the first message.
+ * ringbuffer_read_batch is ringbuffer_read_batch_timed with RB_TIMEOUT_DEFAULT.
+ *
+ * @param context ringbuffer context
+ * @param buffers max_messages output buffers
+ * @param buffer_lens sizes of the output buffers. Sizes of the messages received are stored here
+ * @param max_messages maximum number of messages to read
+ * @param max_bytes byte budget for the whole batch, 0 for no limit (the first message is always read)
+ * @param count number of messages read is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return like ringbuffer_read_batch, RINGBUFFER_EMPTY if the ring stayed empty
+ */
+int ringbuffer_read_batch_timed(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                                size_t max_messages, size_t max_bytes, size_t *count, int64_t timeout_ns);
+
+/**
+ * Write a single message gathered from several fragments, e.g. a header and a payload,
+ * without concatenating them first. The fragments are written in one critical section.
+ *
+ * @param context ringbuffer context
+ * @param iov fragments of the message, in order
+ * @param iovcnt number of fragments
+ * @return SUCESS on succes, RINGBUFFER_FULL when message doesn't fit
+ */
+int ringbuffer_writev(rbctx_t *context, const struct iovec *iov, int iovcnt);
+
+/**
+ * Like ringbuffer_writev, waiting at most timeout_ns for space.
+ *
+ * @param context ringbuffer context
+ * @param iov fragments of the message, in order
+ * @param iovcnt number of fragments
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS on success, RINGBUFFER_FULL if no space became available in time
+ */
+int ringbuffer_writev_timed(rbctx_t *context, const struct iovec *iov, int iovcnt, int64_t timeout_ns);
+
+/**
+ * Read a single message and scatter it across several buffers, filling them in order.
+ *
+ * @param context ringbuffer context
+ * @param iov buffers to fill, in order
+ * @param iovcnt number of buffers
+ * @param message_len size of the message received is stored here
+ * @return SUCCESS on succes, RINGBUFFER_EMPTY if no data to read, OUTPUT_BUFFER_TOO_SMALL (message stays in the ring) when the buffers together are too small
+ */
+int ringbuffer_readv(rbctx_t *context, const struct iovec *iov, int iovcnt, size_t *message_len);
+
+/**
+ * Like ringbuffer_readv, waiting at most timeout_ns for data.
+ *
+ * @param context ringbuffer context
+ * @param iov buffers to fill, in order
+ * @param iovcnt number of buffers
+ * @param message_len size of the message received is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return like ringbuffer_readv, RINGBUFFER_EMPTY if the ring stayed empty
+ */
+int ringbuffer_readv_timed(rbctx_t *context, const struct iovec *iov, int iovcnt, size_t *message_len,
+                           int64_t timeout_ns);
+
+/**
+ * Reserve space for a message of up to message_len bytes that the caller fills in place.
+ * The space stays invisible to readers until ringbuffer_write_commit publishes it.
+ * In RB_MODE_LOCKED the ring (in RB_MODE_TWOLOCK its writer side) stays locked between
+ * reserve and commit/cancel, so keep the reservation short and commit or cancel it from
+ * the same thread.
+ *
+ * @param context ringbuffer context
+ * @param message_len largest message the caller wants to write
+ * @param span receives the reserved area
+ * @return SUCCESS on success, RINGBUFFER_FULL when the message doesn't fit
+ */
+int ringbuffer_write_reserve(rbctx_t *context, size_t message_len, rbspan_t *span);
+
+/**
+ * Like ringbuffer_write_reserve, waiting at most timeout_ns for space.
+ *
+ * @param context ringbuffer context
+ * @param message_len number of bytes to reserve
+ * @param span receives the reserved area
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS on success, RINGBUFFER_FULL if no space became available in time
+ */
+int ringbuffer_write_reserve_timed(rbctx_t *context, size_t message_len, rbspan_t *span, int64_t timeout_ns);
+
+/**
+ * Publish a reserved message.
+ *
+ * @param context ringbuffer context
+ * @param span area returned by ringbuffer_write_reserve
+ * @param message_len number of bytes actually written, at most the reserved size
+ * @return SUCCESS on success, OUTPUT_BUFFER_TOO_SMALL (and the reservation is canceled) when message_len exceeds the reservation
+ */
+int ringbuffer_write_commit(rbctx_t *context, rbspan_t *span, size_t message_len);
+
+/**
+ * Drop a reservation without publishing a message.
+ *
+ * @param context ringbuffer context
+ * @param span area returned by ringbuffer_write_reserve
+ */
+void ringbuffer_write_cancel(rbctx_t *context, rbspan_t *span);
+
+/**
+ * Expose the next message in place without copying it.
+ * The space is handed back to writers by ringbuffer_read_release. In RB_MODE_LOCKED the
+ * ring (in RB_MODE_TWOLOCK its reader side) stays locked until then, in RB_MODE_MPMC the
+ * message is already owned by the caller.
+ *
+ * @param context ringbuffer context
+ * @param span receives the message area, len[0] + len[1] is the message length
+ * @return SUCCESS on success, RINGBUFFER_EMPTY if no data to read
+ */
+int ringbuffer_read_peek(rbctx_t *context, rbspan_t *span);
+
+/**
+ * Like ringbuffer_read_peek, waiting at most timeout_ns for a message.
+ *
+ * @param context ringbuffer context
+ * @param span receives the message area
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS on success, RINGBUFFER_EMPTY if no message arrived in time
+ */
+int ringbuffer_read_peek_timed(rbctx_t *context, rbspan_t *span, int64_t timeout_ns);
+
+/**
+ * Free the space of a peeked message.
+ *
+ * @param context ringbuffer context
+ * @param span area returned by ringbuffer_read_peek
+ */
+void ringbuffer_read_release(rbctx_t *context, rbspan_t *span);
+
+/**
+ * Leave a peeked message in the ring, the next read returns it again.
+ *
+ * @param context ringbuffer context
+ * @param span area returned by ringbuffer_read_peek
+ * @return SUCCESS, or ENOTSUP in RB_MODE_MPMC where the peek already claimed the message (release it instead)
+ */
+int ringbuffer_read_cancel(rbctx_t *context, rbspan_t *span);
+
+/**
+ * Copy into a reserved area, handling the split at the end of the ring.
+ *
+ * @param span area returned by ringbuffer_write_reserve
+ * @param offset offset inside the message
+ * @param src data to copy
+ * @param len number of bytes to copy
+ * @return number of bytes copied
+ */
+size_t ringbuffer_span_write(const rbspan_t *span, size_t offset, const void *src, size_t len);
+
+/**
+ * Copy out of a peeked area, handling the split at the end of the ring.
+ *
+ * @param span area returned by ringbuffer_read_peek
+ * @param offset offset inside the message
+ * @param dst destination
+ * @param len number of bytes to copy
+ * @return number of bytes copied
+ */
+size_t ringbuffer_span_read(const rbspan_t *span, size_t offset, void *dst, size_t len);
+
+/**
+ * Copy the counters of the ring. Every counter is read on its own, so a snapshot taken
+ * while writers and readers are busy need not be consistent across counters.
+ *
+ * @param context ringbuffer context
+ * @param stats receives the counters
+ */
+void ringbuffer_get_stats(rbctx_t *context, rbstats_t *stats);
+
+/**
+ * Set all counters of the ring back to zero. Operations running at the same time may
+ * be counted before or after the reset.
+ *
+ * @param context ringbuffer context
+ */
+void ringbuffer_reset_stats(rbctx_t *context);
+
+/**
+ * Bytes the ring currently holds, taken from its positions rather than the counters.
+ * Length headers and RB_FRAME_FIXED padding are included, in RB_MODE_MPMC every
+ * claimed slot counts slot_size bytes. Writers and readers may change it right after.
+ *
+ * @param context ringbuffer context
+ * @return bytes in use
+ */
+size_t ringbuffer_used(rbctx_t *context);
+
+/**
+ * Summarize one of the latency histograms. The histograms are only kept when the
+ * ringbuffer is compiled with RBUF_HISTOGRAMS, every recorded value costs a clock read.
+ *
+ * @param context ringbuffer context
+ * @param kind histogram to summarize
+ * @param summary receives the percentiles, all zero if nothing was recorded
+ * @return SUCCESS, ENOTSUP without RBUF_HISTOGRAMS, EINVAL for an unknown kind
+ */
+int ringbuffer_get_histogram(rbctx_t *context, rbhist_kind_t kind, rbhist_summary_t *summary);
+
+/**
+ * Clear all latency histograms of the ring.
+ *
+ * @param context ringbuffer context
+ */
+void ringbuffer_reset_histograms(rbctx_t *context);
+
+/**
+ * Give the ring a pair of pollable file descriptors (eventfds) so that an event loop can
+ * wait for it together with sockets, timers and other rings. The data fd becomes readable
+ * when a message arrives, the space fd when a message is consumed. Notifications are
+ * coalesced: a fd is only signaled once per arming, so a burst of messages costs a single
+ * write(2). The data fd is armed by this call and by every read that returns
+ * RINGBUFFER_EMPTY, the space fd by every write or reserve that returns RINGBUFFER_FULL;
+ * arming drains the fd and signals it again at once if the ring changed in the meantime.
+ * A caller that woke up therefore keeps reading (or writing, with RB_TIMEOUT_TRY) until
+ * the ring is empty (full) before it polls again. Call it before other threads use the
+ * ring, ringbuffer_destroy closes the fds.
+ *
+ * @param context ringbuffer context
+ * @return SUCCESS, ENOTSUP outside Linux, EINVAL for a shared ring (eventfds are per process), or an errno value
+ */
+int ringbuffer_enable_poll(rbctx_t *context);
+
+/**
+ * File descriptor that polls readable (POLLIN) when the ring has data.
+ *
+ * @param context ringbuffer context
+ * @return the eventfd, -1 unless ringbuffer_enable_poll succeeded
+ */
+int ringbuffer_data_fd(const rbctx_t *context);
+
+/**
+ * File descriptor that polls readable (POLLIN) when space was freed in the ring.
+ *
+ * @param context ringbuffer context
+ * @return the eventfd, -1 unless ringbuffer_enable_poll succeeded
+ */
+int ringbuffer_space_fd(const rbctx_t *context);
+
 /**
  * Frees all memory allocated and syncronization variables created during initialization.
  * 
@@ -62,4 +763,8 @@ int ringbuffer_read(rbctx_t *context, void *buffer, size_t *buffer_len_ptr);
  */
 void ringbuffer_destroy(rbctx_t *context);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif //RINGBUF_H
@@ -0,0 +1,89 @@
+#ifndef RINGBUF_ARENA_H
+#define RINGBUF_ARENA_H
+
+#include "ringbuf.h"
+
+#define RB_ARENA_NO_BLOCK UINT32_MAX
+
+/*
+ * A pool of equal, cache-line aligned blocks carved out of caller memory, for messages
+ * too large to travel through a ring. Free blocks form a lock-free stack, allocating
+ * and recycling a block never calls malloc or free.
+ *
+ * With ringbuffer_write_large a message longer than threshold is copied into a block
+ * and the ring only carries a small descriptor (block, length). ringbuffer_read_large
+ * copies it out and recycles the block. Shorter messages stay inline in the ring.
+ */
+typedef struct {
+    uint8_t *blocks;
+    size_t block_size;          // bytes per block, a multiple of RB_CACHE_LINE
+    uint32_t block_count;
+    size_t threshold;           // longer messages go into a block
+    RB_ATOMIC(uint32_t) *next;  // free stack links, one per block
+    RB_ATOMIC(uint64_t) free_head; // (generation << 32) | top block, the generation defeats ABA
+    RB_ATOMIC(uint32_t) free_blocks;
+    RB_ATOMIC(uint64_t) large_messages; // messages written out of band
+    RB_ATOMIC(uint64_t) exhausted;      // times a writer found no free block
+    rbwait_t wait;              // how writers wait for a block, RB_WAIT_CONDVAR unless changed before first use
+    pthread_mutex_t mtx;
+    pthread_cond_t freed;       // writers wait here for a free block
+    rbevent_t free_event;       // notified by every free
+} rbarena_t;
+
+/**
+ * Initialize an arena in caller memory.
+ *
+ * @param arena arena
+ * @param memory the first byte location of the arena
+ * @param memory_size size of the memory, links and alignment included
+ * @param block_size largest message the arena takes, rounded up to RB_CACHE_LINE
+ * @param threshold messages longer than this many bytes are written out of band
+ * @return SUCCESS, or EINVAL if not a single block fits or threshold is not below block_size
+ */
+int ringbuffer_arena_init(rbarena_t *arena, void *memory, size_t memory_size, size_t block_size, size_t threshold);
+
+/**
+ * Number of blocks that are currently free.
+ *
+ * @param arena arena
+ * @return free blocks
+ */
+size_t ringbuffer_arena_free_blocks(rbarena_t *arena);
+
+/**
+ * Write a message of any length up to the block size: inline behind a one byte tag up
+ * to the threshold, out of band in an arena block above it. timeout_ns bounds the wait
+ * for a block and for ring space together. For rings of any mode but RB_MODE_MPMC, not
+ * RB_FRAME_FIXED, and the ring must only be used through the *_large functions.
+ *
+ * @param context ringbuffer context
+ * @param arena arena of the ring
+ * @param message message to be stored
+ * @param message_len length of message to be stored in bytes
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, RINGBUFFER_FULL if no block or ring space became available in time or the message is longer than a block,
+ *         ENOTSUP for RB_MODE_MPMC and RB_FRAME_FIXED
+ */
+int ringbuffer_write_large(rbctx_t *context, rbarena_t *arena, const void *message, size_t message_len, int64_t timeout_ns);
+
+/**
+ * Read a message written by ringbuffer_write_large, wherever it is stored.
+ *
+ * @param context ringbuffer context
+ * @param arena arena of the ring
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, RINGBUFFER_EMPTY if no message arrived in time, OUTPUT_BUFFER_TOO_SMALL (the message stays) when it doesn't fit,
+ *         ENOTSUP for RB_MODE_MPMC and RB_FRAME_FIXED
+ */
+int ringbuffer_read_large(rbctx_t *context, rbarena_t *arena, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns);
+
+/**
+ * Destroy the synchronization variables of the arena.
+ *
+ * @param arena arena
+ */
+void ringbuffer_arena_destroy(rbarena_t *arena);
+
+#endif //RINGBUF_ARENA_H
@@ -0,0 +1,165 @@
+#ifndef RINGBUF_CHANNEL_HPP
+#define RINGBUF_CHANNEL_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "ringbuf.h"
+
+namespace ringbuf {
+
+/*
+ * A ring of values of type T with room for exactly Capacity of them, buffer and
+ * synchronization owned by the object. Every value occupies one RB_FRAME_FIXED record,
+ * so no length prefix is written or parsed, and since the ring is a whole number of
+ * records no value is ever split at its end.
+ *
+ * Trivially copyable values are copied in and out with memcpy. Other types are
+ * constructed in place in the ring and moved out of it, and values still in the ring
+ * are destroyed with the channel.
+ *
+ * The status codes and timeouts are those of the C functions. The object refers to
+ * itself and is neither copyable nor movable.
+ */
+template <class T, std::size_t Capacity, rbmode_t Mode = RB_MODE_LOCKED>
+class channel {
+    static_assert(Capacity > 0 && std::has_single_bit(Capacity), "Capacity must be a power of two");
+    static_assert(Mode == RB_MODE_LOCKED || Mode == RB_MODE_SPSC, "records need RB_MODE_LOCKED or RB_MODE_SPSC");
+    static_assert(std::is_trivially_copyable_v<T> ||
+                  (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>),
+                  "values are moved out of the ring with the ring locked, moves must not throw");
+
+public:
+    using value_type = T;
+    static constexpr std::size_t capacity = Capacity;
+    // RB_MODE_SPSC needs a power-of-two ring, the record is padded to one
+    static constexpr std::size_t record_size = (Mode == RB_MODE_SPSC) ? std::bit_ceil(sizeof(T)) : sizeof(T);
+
+    explicit channel(rbwait_t wait = RB_WAIT_DEFAULT)
+    {
+        rbattr_t attr;
+        ringbuffer_attr_init(&attr);
+        attr.mode = Mode;
+        attr.wait = wait;
+        attr.framing = RB_FRAME_FIXED;
+        attr.slot_size = record_size;
+        ringbuffer_init_attr(&ctx_, buffer_, sizeof(buffer_), &attr);
+    }
+
+    ~channel()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            rbspan_t span;
+            while (ringbuffer_read_peek_timed(&ctx_, &span, RB_TIMEOUT_TRY) == SUCCESS) {
+                std::launder(reinterpret_cast<T *>(span.ptr[0]))->~T();
+                ringbuffer_read_release(&ctx_, &span);
+            }
+        }
+        ringbuffer_destroy(&ctx_);
+    }
+
+    channel(const channel &) = delete;
+    channel &operator=(const channel &) = delete;
+
+    /**
+     * Append a copy of value, waiting at most timeout_ns for a free record.
+     *
+     * @return SUCCESS, or RINGBUFFER_FULL if the channel stayed full
+     */
+    int push(const T &value, int64_t timeout_ns = RB_TIMEOUT_DEFAULT)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return ringbuffer_write_timed(&ctx_, const_cast<T *>(&value), sizeof(T), timeout_ns);
+        } else {
+            return emplace_timed(timeout_ns, value);
+        }
+    }
+
+    /**
+     * Move value into the channel, waiting at most timeout_ns for a free record.
+     * value is left untouched if the channel stayed full.
+     *
+     * @return SUCCESS, or RINGBUFFER_FULL if the channel stayed full
+     */
+    int push(T &&value, int64_t timeout_ns = RB_TIMEOUT_DEFAULT)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return ringbuffer_write_timed(&ctx_, &value, sizeof(T), timeout_ns);
+        } else {
+            return emplace_timed(timeout_ns, std::move(value));
+        }
+    }
+
+    /**
+     * Construct a value from args directly in the ring, waiting at most timeout_ns for
+     * a free record. An exception thrown by the constructor cancels the record.
+     *
+     * @return SUCCESS, or RINGBUFFER_FULL if the channel stayed full
+     */
+    template <class... Args>
+    int emplace_timed(int64_t timeout_ns, Args &&...args)
+    {
+        rbspan_t span;
+        int res = ringbuffer_write_reserve_timed(&ctx_, sizeof(T), &span, timeout_ns);
+        if (res != SUCCESS) {
+            return res;
+        }
+        try {
+            ::new (static_cast<void *>(span.ptr[0])) T(std::forward<Args>(args)...);
+        } catch (...) {
+            ringbuffer_write_cancel(&ctx_, &span);
+            throw;
+        }
+        return ringbuffer_write_commit(&ctx_, &span, sizeof(T));
+    }
+
+    /**
+     * Move the oldest value into value, waiting at most timeout_ns for one.
+     *
+     * @return SUCCESS, or RINGBUFFER_EMPTY if the channel stayed empty
+     */
+    int pop(T &value, int64_t timeout_ns = RB_TIMEOUT_DEFAULT)
+    {
+        if constexpr (std::is_trivially_copyable_v<T> && record_size == sizeof(T)) {
+            std::size_t len = sizeof(T);
+            return ringbuffer_read_timed(&ctx_, &value, &len, timeout_ns);
+        } else {
+            rbspan_t span;
+            int res = ringbuffer_read_peek_timed(&ctx_, &span, timeout_ns);
+            if (res != SUCCESS) {
+                return res;
+            }
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                std::memcpy(&value, span.ptr[0], sizeof(T));
+            } else {
+                T *stored = std::launder(reinterpret_cast<T *>(span.ptr[0]));
+                value = std::move(*stored);
+                stored->~T();
+            }
+            ringbuffer_read_release(&ctx_, &span);
+            return SUCCESS;
+        }
+    }
+
+    /**
+     * The underlying ring, for ringbuffer_get_stats, ringbuffer_enable_poll and the like.
+     * Reading or writing it directly bypasses the records of the channel.
+     */
+    rbctx_t *native_handle() { return &ctx_; }
+
+private:
+    // the locked ring keeps one byte free to tell full from empty, one extra record covers it
+    static constexpr std::size_t buffer_size = (Mode == RB_MODE_SPSC ? Capacity : Capacity + 1) * record_size;
+
+    rbctx_t ctx_;
+    alignas(std::max<std::size_t>(RB_CACHE_LINE, alignof(T))) unsigned char buffer_[buffer_size];
+};
+
+} // namespace ringbuf
+
+#endif //RINGBUF_CHANNEL_HPP
@@ -0,0 +1,265 @@
+#ifndef RINGBUF_CORO_HPP
+#define RINGBUF_CORO_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "ringbuf_channel.hpp"
+
+namespace ringbuf {
+
+/*
+ * Resumes a coroutine right in the thread that made its operation complete. Any type
+ * with a schedule(std::coroutine_handle<>) member can take its place, typically one that
+ * posts the handle to an executor.
+ */
+struct inline_scheduler {
+    void schedule(std::coroutine_handle<> handle) const { handle.resume(); }
+};
+
+/*
+ * A channel whose push and pop can be awaited. An operation that finds the channel full
+ * (empty) suspends the coroutine instead of blocking the thread. The next operation that
+ * frees a record (adds a value) completes it on the coroutine's behalf, in the order the
+ * coroutines suspended, and hands the coroutine to the scheduler to resume. While pushes
+ * (pops) are suspended, later pushes (pops) queue up behind them instead of overtaking.
+ *
+ * Every operation must go through this object (async_* or try_*): an operation on the
+ * underlying ring wakes nobody. Awaited operations never time out, and no coroutine may
+ * still be suspended on the channel when it is destroyed.
+ */
+template <class T, std::size_t Capacity, rbmode_t Mode = RB_MODE_LOCKED, class Scheduler = inline_scheduler>
+class async_channel {
+    static_assert(std::is_default_constructible_v<T>, "a suspended pop receives its value into a T");
+
+    // a suspended operation, lives in the awaiting coroutine's frame
+    struct waiter {
+        waiter *next = nullptr;
+        std::coroutine_handle<> handle;
+    };
+
+public:
+    using value_type = T;
+    static constexpr std::size_t capacity = Capacity;
+
+    explicit async_channel(Scheduler scheduler = Scheduler{}) : scheduler_(std::move(scheduler)) {}
+
+    async_channel(const async_channel &) = delete;
+    async_channel &operator=(const async_channel &) = delete;
+
+    class push_awaiter : waiter {
+    public:
+        bool await_ready() { return channel_.try_push(std::move(value_)) == SUCCESS; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            this->handle = handle;
+            return channel_.suspend(channel_.pushers_, this);
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        friend class async_channel;
+        push_awaiter(async_channel &channel, T &&value) : channel_(channel), value_(std::move(value)) {}
+
+        async_channel &channel_;
+        T value_;
+    };
+
+    class pop_awaiter : waiter {
+    public:
+        bool await_ready() { return channel_.try_pop(value_) == SUCCESS; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            this->handle = handle;
+            return channel_.suspend(channel_.poppers_, this);
+        }
+        T await_resume() { return std::move(value_); }
+
+    private:
+        friend class async_channel;
+        explicit pop_awaiter(async_channel &channel) : channel_(channel) {}
+
+        async_channel &channel_;
+        T value_{};
+    };
+
+    /**
+     * co_await appends value, suspending while the channel is full.
+     */
+    [[nodiscard]] push_awaiter async_push(T value) { return push_awaiter(*this, std::move(value)); }
+
+    /**
+     * co_await yields the oldest value, suspending while the channel is empty.
+     */
+    [[nodiscard]] pop_awaiter async_pop() { return pop_awaiter(*this); }
+
+    /**
+     * Append value without waiting, value is left untouched if the channel is full or
+     * suspended pushes are still queued.
+     *
+     * @return SUCCESS, or RINGBUFFER_FULL
+     */
+    int try_push(T &&value)
+    {
+        if (pushers_.waiting.load(std::memory_order_relaxed) != 0) {
+            return RINGBUFFER_FULL; // the next free record is theirs
+        }
+        int res = channel_.push(std::move(value), RB_TIMEOUT_TRY);
+        if (res == SUCCESS) {
+            settle();
+        }
+        return res;
+    }
+
+    int try_push(const T &value)
+    {
+        if (pushers_.waiting.load(std::memory_order_relaxed) != 0) {
+            return RINGBUFFER_FULL;
+        }
+        int res = channel_.push(value, RB_TIMEOUT_TRY);
+        if (res == SUCCESS) {
+            settle();
+        }
+        return res;
+    }
+
+    /**
+     * Move the oldest value into value without waiting, fails while suspended pops are
+     * still queued.
+     *
+     * @return SUCCESS, or RINGBUFFER_EMPTY
+     */
+    int try_pop(T &value)
+    {
+        if (poppers_.waiting.load(std::memory_order_relaxed) != 0) {
+            return RINGBUFFER_EMPTY; // the next value is theirs
+        }
+        int res = channel_.pop(value, RB_TIMEOUT_TRY);
+        if (res == SUCCESS) {
+            settle();
+        }
+        return res;
+    }
+
+    /**
+     * The underlying ring, for ringbuffer_get_stats and the like.
+     */
+    rbctx_t *native_handle() { return channel_.native_handle(); }
+
+private:
+    struct queue {
+        waiter *head = nullptr;
+        waiter *tail = nullptr;
+        std::atomic<std::size_t> waiting{0}; // read without mtx_ by the fast paths
+
+        void push(waiter *w)
+        {
+            w->next = nullptr;
+            (tail ? tail->next : head) = w;
+            tail = w;
+            waiting.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        waiter *pop()
+        {
+            waiter *w = head;
+            head = w->next;
+            if (head == nullptr) {
+                tail = nullptr;
+            }
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+            return w;
+        }
+    };
+
+    /*
+     * Completes suspended operations for as long as they make progress, with mtx_ held.
+     * A completed pop frees a record for a pusher and the other way around. The handles
+     * to resume are chained through their waiters and scheduled after mtx_ is released.
+     */
+    waiter *complete_locked()
+    {
+        queue done;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            while (poppers_.head != nullptr &&
+                   channel_.pop(static_cast<pop_awaiter *>(poppers_.head)->value_, RB_TIMEOUT_TRY) == SUCCESS) {
+                done.push(poppers_.pop());
+                progress = true;
+            }
+            while (pushers_.head != nullptr &&
+                   channel_.push(std::move(static_cast<push_awaiter *>(pushers_.head)->value_), RB_TIMEOUT_TRY) == SUCCESS) {
+                done.push(pushers_.pop());
+                progress = true;
+            }
+        }
+        return done.head;
+    }
+
+    void resume(waiter *w)
+    {
+        while (w != nullptr) {
+            waiter *next = w->next; // the coroutine may end, and the waiter with it, once resumed
+            scheduler_.schedule(w->handle);
+            w = next;
+        }
+    }
+
+    /*
+     * Called after every successful operation. Pairs with the fence in suspend: either we
+     * see the new waiter, or the suspending coroutine sees our change of the ring.
+     */
+    void settle()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pushers_.waiting.load(std::memory_order_relaxed) == 0 &&
+            poppers_.waiting.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        std::unique_lock lock(mtx_);
+        waiter *done = complete_locked();
+        lock.unlock();
+        resume(done);
+    }
+
+    /*
+     * Queues w and tries once more, the ring may have changed since await_ready. Returns
+     * false if w completed right away and the coroutine need not suspend.
+     */
+    bool suspend(queue &q, waiter *w)
+    {
+        std::unique_lock lock(mtx_);
+        q.push(w);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        waiter *done = complete_locked();
+        lock.unlock();
+
+        bool suspended = true;
+        waiter **link = &done;
+        while (*link != nullptr) {
+            if (*link == w) {
+                *link = w->next;
+                suspended = false;
+                break;
+            }
+            link = &(*link)->next;
+        }
+        resume(done);
+        return suspended;
+    }
+
+    channel<T, Capacity, Mode> channel_;
+    Scheduler scheduler_;
+    std::mutex mtx_; // protects the queues
+    queue pushers_;  // suspended pushes, oldest first
+    queue poppers_;  // suspended pops, oldest first
+};
+
+} // namespace ringbuf
+
+#endif //RINGBUF_CORO_HPP
@@ -0,0 +1,112 @@
+#ifndef RINGBUF_FANIN_H
+#define RINGBUF_FANIN_H
+
+#include "ringbuf.h"
+
+#define RB_FANIN_MAX_PRODUCERS 64 // one bit of the ready mask each
+
+typedef enum {
+    RB_FANIN_FREE = 0, // no producer, the ring is not initialized
+    RB_FANIN_OPEN,     // a producer writes to the ring
+    RB_FANIN_CLOSED,   // the producer left, consumers drain the ring and free it
+} rbfanin_state_t;
+
+/*
+ * Consumer side of one producer ring, on its own cache line.
+ */
+typedef struct {
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(int) reading; // a consumer has the ring, the others skip it
+    RB_ATOMIC(int) state;                             // rbfanin_state_t
+} rbfanin_slot_t;
+
+/*
+ * Many producers, any number of consumers, no shared write path: every producer gets a
+ * private RB_MODE_SPSC ring and only marks it in the ready mask when it was not marked
+ * yet. Consumers scan the mask round-robin and take one ring at a time, so the messages
+ * of one producer are read in the order they were written. Producers register and
+ * deregister at any time, the ring of a deregistered producer is freed once it is drained.
+ *
+ * The rings are embedded, so the structure is large: allocate it, don't put it on the stack.
+ */
+typedef struct {
+    rbctx_t ring[RB_FANIN_MAX_PRODUCERS];
+    rbfanin_slot_t slot[RB_FANIN_MAX_PRODUCERS];
+    uint8_t *begin;             // first ring, cache-line aligned
+    size_t ring_size;           // bytes per ring, a power of two
+    size_t producers;           // number of rings, at most RB_FANIN_MAX_PRODUCERS
+    rbattr_t attr;              // attributes of every ring, mode RB_MODE_SPSC
+    pthread_mutex_t reg_mtx;    // serializes register and the freeing of closed rings
+    rbwait_t wait;              // how consumers wait, attr.wait or RB_WAIT_CONDVAR for RB_WAIT_DEFAULT
+    pthread_mutex_t mtx;        // protects the condition variable
+    pthread_cond_t sig;         // consumers wait here for a ring to become ready
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(uint64_t) ready; // rings that may hold messages
+    rbevent_t ready_event;      // notified whenever a ring becomes ready
+    RB_ATOMIC(unsigned) next;   // where the next scan starts
+} rbfanin_t;
+
+/**
+ * Initialize a fan-in without producers. The buffer is split into producers rings of
+ * the largest power of two that fits.
+ *
+ * @param fanin fan-in
+ * @param buffer_location the first byte location of the rings in memory
+ * @param buffer_size size of the memory
+ * @param producers most producers registered at once, at most RB_FANIN_MAX_PRODUCERS
+ * @param attr attributes of the rings (wait strategy, framing), NULL for the defaults; the mode is always RB_MODE_SPSC
+ * @return SUCCESS, or EINVAL for 0 or too many producers or rings too small to hold a length header
+ */
+int ringbuffer_fanin_init(rbfanin_t *fanin, void *buffer_location, size_t buffer_size, size_t producers,
+                          const rbattr_t *attr);
+
+/**
+ * Give the calling producer a private ring. Only the producer writes to it, from one
+ * thread at a time.
+ *
+ * @param fanin fan-in
+ * @param producer id of the new producer is stored here
+ * @return SUCCESS, or EAGAIN if every ring is taken or still being drained
+ */
+int ringbuffer_fanin_register(rbfanin_t *fanin, unsigned *producer);
+
+/**
+ * Leave the fan-in. Messages already written are still read, the ring is freed after
+ * the last of them. The producer must not write afterwards.
+ *
+ * @param fanin fan-in
+ * @param producer id returned by ringbuffer_fanin_register
+ */
+void ringbuffer_fanin_deregister(rbfanin_t *fanin, unsigned producer);
+
+/**
+ * Write a message into the producer's ring, waiting at most timeout_ns for space in it.
+ *
+ * @param fanin fan-in
+ * @param producer id returned by ringbuffer_fanin_register
+ * @param message message to be stored
+ * @param message_len length of message to be stored in bytes
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, RINGBUFFER_FULL if the ring stayed full, EINVAL for an unknown producer
+ */
+int ringbuffer_fanin_write(rbfanin_t *fanin, unsigned producer, void *message, size_t message_len, int64_t timeout_ns);
+
+/**
+ * Read the next message of the next ready producer, waiting at most timeout_ns until
+ * any producer has one.
+ *
+ * @param fanin fan-in
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @param producer producer the message came from is stored here, may be NULL
+ * @return SUCCESS, RINGBUFFER_EMPTY if no message arrived in time, OUTPUT_BUFFER_TOO_SMALL (the message stays) when it doesn't fit
+ */
+int ringbuffer_fanin_read(rbfanin_t *fanin, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns, unsigned *producer);
+
+/**
+ * Destroy all rings and the synchronization variables of the fan-in.
+ *
+ * @param fanin fan-in
+ */
+void ringbuffer_fanin_destroy(rbfanin_t *fanin);
+
+#endif //RINGBUF_FANIN_H
@@ -0,0 +1,107 @@
+#ifndef RINGBUF_MCAST_H
+#define RINGBUF_MCAST_H
+
+#include "ringbuf.h"
+
+#define RB_MCAST_MAX_CONSUMERS 16
+
+/*
+ * Read cursor of one consumer, on its own cache line.
+ */
+typedef struct {
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(size_t) head; // bytes this consumer has read so far
+    RB_ATOMIC(int) active;
+} rbmcast_consumer_t;
+
+/*
+ * A broadcast ring: every message written is read by every consumer subscribed at the
+ * time, each at its own pace through its own cursor. Writers are only held back by the
+ * slowest consumer, a message is gone once all consumers read it. Writers serialize on
+ * a mutex, consumers read without locks and may subscribe and unsubscribe at any time.
+ */
+typedef struct {
+    uint8_t *begin;
+    size_t mask;               // capacity - 1, the capacity is a power of two
+    pthread_mutex_t write_mtx; // serializes writers, subscribe and unsubscribe
+    size_t gate_cache;         // the writers' last view of the slowest cursor, write_mtx held
+    rbwait_t wait;             // how blocked callers wait, RB_WAIT_CONDVAR unless changed before first use
+    pthread_mutex_t mtx;       // protects the condition variables
+    pthread_cond_t data;       // consumers wait here for messages
+    pthread_cond_t space;      // writers wait here for the slowest consumer
+    rbevent_t data_event;      // notified by every write
+    rbevent_t space_event;     // notified by every read and unsubscribe
+    RB_ALIGNAS(RB_CACHE_LINE) RB_ATOMIC(size_t) tail; // bytes written so far
+    rbmcast_consumer_t consumers[RB_MCAST_MAX_CONSUMERS];
+} rbmcast_t;
+
+/**
+ * Initialize a multicast ring without consumers.
+ *
+ * @param mc multicast ring
+ * @param buffer_location the first byte location of the ring in memory
+ * @param buffer_size size of the memory, the largest power of two that fits is used
+ * @return SUCCESS, or EINVAL if the buffer cannot hold a length header
+ */
+int ringbuffer_mcast_init(rbmcast_t *mc, void *buffer_location, size_t buffer_size);
+
+/**
+ * Register a consumer. It reads every message written from now on.
+ *
+ * @param mc multicast ring
+ * @param consumer id of the new consumer is stored here
+ * @return SUCCESS, or EAGAIN if RB_MCAST_MAX_CONSUMERS consumers are subscribed
+ */
+int ringbuffer_mcast_subscribe(rbmcast_t *mc, unsigned *consumer);
+
+/**
+ * Remove a consumer, writers no longer wait for it. Must not race with a read of the
+ * same consumer.
+ *
+ * @param mc multicast ring
+ * @param consumer id returned by ringbuffer_mcast_subscribe
+ */
+void ringbuffer_mcast_unsubscribe(rbmcast_t *mc, unsigned consumer);
+
+/**
+ * Write a message for all consumers, waiting at most timeout_ns until the slowest of
+ * them made room for it. Without consumers the message is dropped right away.
+ *
+ * @param mc multicast ring
+ * @param message message to be stored
+ * @param message_len length of message to be stored in bytes
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, or RINGBUFFER_FULL if the slowest consumer did not make room in time or the message can never fit
+ */
+int ringbuffer_mcast_write(rbmcast_t *mc, const void *message, size_t message_len, int64_t timeout_ns);
+
+/**
+ * Read the next message of one consumer, waiting at most timeout_ns for it. Only one
+ * thread may read for a consumer at a time.
+ *
+ * @param mc multicast ring
+ * @param consumer id returned by ringbuffer_mcast_subscribe
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, RINGBUFFER_EMPTY if no message arrived in time, OUTPUT_BUFFER_TOO_SMALL (the message stays) when it doesn't fit,
+ *         EINVAL for an unknown consumer
+ */
+int ringbuffer_mcast_read(rbmcast_t *mc, unsigned consumer, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns);
+
+/**
+ * Bytes, length headers included, that a consumer still has to read.
+ *
+ * @param mc multicast ring
+ * @param consumer id returned by ringbuffer_mcast_subscribe
+ * @return bytes behind the writers
+ */
+size_t ringbuffer_mcast_lag(rbmcast_t *mc, unsigned consumer);
+
+/**
+ * Destroy the synchronization variables of the ring.
+ *
+ * @param mc multicast ring
+ */
+void ringbuffer_mcast_destroy(rbmcast_t *mc);
+
+#endif //RINGBUF_MCAST_H
@@ -0,0 +1,107 @@
+#ifndef RINGBUF_PRIO_H
+#define RINGBUF_PRIO_H
+
+#include "ringbuf.h"
+
+#define RB_PRIO_MAX_LANES 8
+
+typedef enum {
+    RB_PRIO_STRICT = 0, // always serve the highest priority lane that has a message
+    RB_PRIO_WEIGHTED,   // weighted round-robin: lane i delivers up to weights[i] messages per round
+} rbprio_policy_t;
+
+typedef struct {
+    size_t lanes;                         // number of lanes, at most RB_PRIO_MAX_LANES
+    rbprio_policy_t policy;
+    unsigned weights[RB_PRIO_MAX_LANES];  // RB_PRIO_WEIGHTED: messages per round, at least 1
+    rbattr_t ring;                        // attributes of every lane
+} rbprio_attr_t;
+
+/*
+ * Several rings behind one handle, lane 0 has the highest priority. Every lane is an
+ * independent ring, a blocked writer only waits for space in its own lane. Readers wait
+ * on the handle for a message in any lane.
+ */
+typedef struct {
+    rbctx_t lane[RB_PRIO_MAX_LANES];
+    size_t lanes;
+    rbprio_policy_t policy;
+    unsigned weights[RB_PRIO_MAX_LANES];
+    size_t current;        // RB_PRIO_WEIGHTED: lane whose turn it is, only touched with mtx held
+    unsigned credit;       // RB_PRIO_WEIGHTED: messages the current lane may still deliver this round
+    rbwait_t wait;         // how readers wait, the lanes' strategy, RB_WAIT_CONDVAR for RB_WAIT_DEFAULT
+    pthread_mutex_t mtx;
+    pthread_cond_t sig;    // readers wait here for a message in any lane
+    rbevent_t data_event;  // notified by every write
+} rbprio_t;
+
+/*
+ * Snapshot returned by ringbuffer_prio_get_stats.
+ */
+typedef struct {
+    rbstats_t lane[RB_PRIO_MAX_LANES]; // counters of every lane, empty_timeouts includes lanes a reader found empty
+    size_t queued_bytes[RB_PRIO_MAX_LANES]; // bytes waiting in every lane (ringbuffer_used)
+} rbprio_stats_t;
+
+/**
+ * Initialize priority ring attributes: four lanes, strict priority, weights 8, 4, 2, 1, ...
+ * and the default ring attributes.
+ *
+ * @param attr attributes to initialize
+ */
+void ringbuffer_prio_attr_init(rbprio_attr_t *attr);
+
+/**
+ * Initialize a priority ring. The buffer is split into attr->lanes lanes of equal,
+ * cache-line aligned size.
+ *
+ * @param prio priority ring
+ * @param buffer_location the first byte location of the lanes in memory
+ * @param buffer_size size of the memory
+ * @param attr priority ring attributes, NULL for the defaults
+ * @return SUCCESS, or EINVAL for 0 or more than RB_PRIO_MAX_LANES lanes or a weight of 0
+ */
+int ringbuffer_prio_init(rbprio_t *prio, void *buffer_location, size_t buffer_size, const rbprio_attr_t *attr);
+
+/**
+ * Write a message into the lane of its priority, waiting at most timeout_ns for space
+ * in that lane.
+ *
+ * @param prio priority ring
+ * @param priority lane of the message, 0 is the highest priority
+ * @param message message to be stored
+ * @param message_len length of message to be stored in bytes
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @return SUCCESS, RINGBUFFER_FULL if the lane stayed full, EINVAL for an unknown priority
+ */
+int ringbuffer_prio_write(rbprio_t *prio, unsigned priority, void *message, size_t message_len, int64_t timeout_ns);
+
+/**
+ * Read the next message as chosen by the policy, waiting at most timeout_ns until any
+ * lane has one.
+ *
+ * @param prio priority ring
+ * @param buffer reads to this location
+ * @param buffer_len_ptr size of the message buffer. Size of message received is stored here
+ * @param timeout_ns how long to wait in nanoseconds, RB_TIMEOUT_TRY or RB_TIMEOUT_INFINITE
+ * @param priority lane the message came from is stored here, may be NULL
+ * @return SUCCESS, RINGBUFFER_EMPTY if all lanes stayed empty, OUTPUT_BUFFER_TOO_SMALL when the chosen message doesn't fit
+ */
+int ringbuffer_prio_read(rbprio_t *prio, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns, unsigned *priority);
+
+/**
+ * Copy the counters and the bytes queued in every lane.
+ *
+ * @param prio priority ring
+ * @param stats receives the counters
+ */
+void ringbuffer_prio_get_stats(rbprio_t *prio, rbprio_stats_t *stats);
+
+/**
+ * Destroy all lanes and the synchronization variables of the handle.
+ *
+ * @param prio priority ring
+ */
+void ringbuffer_prio_destroy(rbprio_t *prio);
+
+#endif //RINGBUF_PRIO_H
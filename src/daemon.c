@@ -2,11 +2,15 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <poll.h>
 
 #include "../include/daemon.h"
 #include <pthread.h>
 #include "../include/ringbuf.h"
 
+// fixed records are read back zero-padded to slot_size, the padding would be forwarded as payload
+_Static_assert(DAEMON_RING_FRAMING != RB_FRAME_FIXED, "simpledaemon needs a length header, RB_FRAME_FIXED is not supported");
+
 /* IN THE FOLLOWING IS THE CODE PROVIDED FOR YOU 
  * changing the code will result in points deduction */
 
@@ -44,20 +48,54 @@ void* write_packets(void* arg) {
         exit(1);
     }
 
-    /* read file in chunks and write to ringbuffer with random delay */
+    /* read file in chunks with random delay. RB_MODE_SPSC freads straight into the reserved
+     * area, only its single consumer waits for the commit. Everywhere else a reservation
+     * holds up others until commit (the mutex in the locked modes, the claimed slot every
+     * MPMC reader has to pass in order), so the chunk is read into buf first */
+    int in_place = ctx->mode == RB_MODE_SPSC;
     unsigned char buf[MESSAGE_SIZE];
+    size_t header_len = sizeof(packet_header_t);
     size_t packet_id = 0;
     size_t read = 1;
     while (read > 0) {
-        size_t msg_size = MESSAGE_SIZE - 3 * sizeof(size_t);
-        read = fread(buf + 3 * sizeof(size_t), 1, msg_size, fp);
-        if (read > 0) {
-            memcpy(buf, &from, sizeof(size_t));
-            memcpy(buf + sizeof(size_t), &to, sizeof(size_t));
-            memcpy(buf + 2 * sizeof(size_t), &packet_id, sizeof(size_t));
-            while(ringbuffer_write(ctx, buf, read + 3 * sizeof(size_t)) != SUCCESS){
-                usleep(((rand() % 50) + 25)); // sleep for a random time between 25 and 75 us
+        size_t len = header_len + PACKET_PAYLOAD_SIZE;
+        if (!in_place) {
+            read = fread(buf, 1, PACKET_PAYLOAD_SIZE, fp);
+            if (read == 0) {
+                break;
+            }
+            len = header_len + read;
+        }
+        rbspan_t span;
+        while(ringbuffer_write_reserve(ctx, len, &span) != SUCCESS){
+            usleep(((rand() % 50) + 25)); // sleep for a random time between 25 and 75 us
+        }
+        if (in_place) {
+            /* the payload goes behind the header, the reserved area may wrap around */
+            read = 0;
+            size_t offset = header_len;
+            for (int i = 0; i < 2; i++) {
+                if (offset >= span.len[i]) {
+                    offset -= span.len[i];
+                    continue;
+                }
+                size_t chunk = span.len[i] - offset;
+                size_t got = fread(span.ptr[i] + offset, 1, chunk, fp);
+                read += got;
+                offset = 0;
+                if (got < chunk) {
+                    break;
+                }
             }
+        } else {
+            ringbuffer_span_write(&span, header_len, buf, read);
+        }
+        if (read > 0) {
+            packet_header_t header = {packet_id, from, to};
+            ringbuffer_span_write(&span, 0, &header, header_len);
+            ringbuffer_write_commit(ctx, &span, read + header_len);
+        } else {
+            ringbuffer_write_cancel(ctx, &span);
         }
         packet_id++;
         usleep(((rand() % (100 -1)) + 1)); // sleep for a random time between 1 and 100 us
@@ -215,6 +253,62 @@ int forwarding(connection_r *conn, void *buf, size_t buffer_len) {
     return write;
 }
 
+/**
+ * @brief Processes a single packet read from the ringbuffer: waits for its turn on the source port, filters and forwards it.
+ *
+ * Packets of the same source port are forwarded strictly in packet_id order. The buffer has to hold at
+ * least one byte behind the packet, which is set to 0 for the firewall.
+ *
+ * @param conn A pointer to a `connection_r` structure that receives the ports of the packet.
+ * @param buf Pointer to the packet (header followed by contents).
+ * @param buffer_len The length of the packet including the header.
+ */
+void process_packet(connection_r *conn, unsigned char *buf, size_t buffer_len) {
+    packet_header_t header;
+    size_t header_len = sizeof(header);
+    unsigned char *contents = buf + header_len; // firewall and forwarding work on buf directly
+
+    if (buffer_len <= header_len) {
+        return;
+    }
+    buf[buffer_len] = 0; // terminate contents for the firewall
+
+    memcpy(&header, buf, header_len);
+    conn->from_port = header.from;
+    conn->to_port = header.to;
+    size_t packet_id = header.packet_id;
+
+    // safety check
+    if (conn->from_port > MAXIMUM_PORT || conn->to_port > MAXIMUM_PORT ||
+        conn->from_port < MINIMUM_PORT || conn->to_port < MINIMUM_PORT) {
+        fprintf(stderr, "Port numbers %zu and/or %zu are too large\n", conn->from_port, conn->to_port);
+        exit(1);
+    }
+
+    pthread_mutex_lock(&port_array[conn->from_port].mutex);
+
+    while (packet_id != port_array[conn->from_port].last_packet_id + 1) {
+        pthread_cond_wait(&port_array[conn->from_port].signal, &port_array[conn->from_port].mutex);
+    }
+    // update packet id
+    port_array[conn->from_port].last_packet_id = packet_id;
+
+    // firewall: filter on port and "malicious" and decide if drop the message or not, if not , write to the file 
+    if (firewall(conn, contents, buffer_len - header_len) == 0) {
+        size_t write = forwarding(conn, // meta information: ports
+                                contents,  // buffer (contents)
+                                (buffer_len - header_len)); // buffer length
+        if (write != buffer_len - header_len) {
+            // an error occured
+            fprintf(stderr, "Error with forwarding\n");
+        }
+    }
+    // unlock packet id mutex
+    pthread_mutex_unlock(&port_array[conn->from_port].mutex);
+    // broadcast signal
+    pthread_cond_broadcast(&port_array[conn->from_port].signal);
+}
+
 void* read_packets(void* arg) {
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
@@ -223,59 +317,33 @@ void* read_packets(void* arg) {
     rbctx_t* ctx = thread_args->ctx;
     connection_r* conn = thread_args->conn; 
 
-    /* read ringbuffer in chunks and write to file with delay 10 us */
-    unsigned char buf[MESSAGE_SIZE + 3 * sizeof(size_t)];
-    size_t buffer_len = sizeof(buf);
-    size_t packet_id = 0;
-    unsigned char contents[buffer_len];
-    memset(&contents, 0, buffer_len); // clearing contents
+    /* read ringbuffer in batches, wait on the ring's data fd while it is empty */
+    unsigned char bufs[READ_BATCH_SIZE][MESSAGE_SIZE + 1]; // + 1 for the firewall terminator
+    void *buffers[READ_BATCH_SIZE];
+    size_t buffer_lens[READ_BATCH_SIZE];
+    size_t count = 0;
+    for (int i = 0; i < READ_BATCH_SIZE; i++) {
+        buffers[i] = bufs[i];
+        buffer_lens[i] = sizeof(bufs[i]) - 1;
+    }
     do {
-        while(ringbuffer_read(ctx, &buf, &buffer_len) != SUCCESS){
-            buffer_len = MESSAGE_SIZE + 3 * sizeof(size_t);
+        // the read never waits, poll is the only place a reader blocks (and can be cancelled)
+        while(ringbuffer_read_batch_timed(ctx, buffers, buffer_lens, READ_BATCH_SIZE, 0, &count, RB_TIMEOUT_TRY) != SUCCESS){
             pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-            usleep(10); // sleep for 10 us
+            // an empty read armed the data fd, it turns readable once a packet arrives.
+            // the timeout covers reads that failed for another reason
+            struct pollfd pfd = {ringbuffer_data_fd(ctx), POLLIN, 0};
+            if (pfd.fd < 0 || poll(&pfd, 1, READ_POLL_TIMEOUT_MS) < 0) {
+                usleep(10); // sleep for 10 us
+            }
             pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
         }
 
-        if (buffer_len >  3 * sizeof(size_t)) {
-            memcpy(&conn->from_port, buf, sizeof(size_t));
-            memcpy(&conn->to_port, buf + sizeof(size_t) , sizeof(size_t));
-            memcpy(&packet_id, buf + 2 * sizeof(size_t), sizeof(size_t));
-            memcpy(contents, buf + 3 * sizeof(size_t), buffer_len - 3 * sizeof(size_t)); 
-
-            // safety check
-            if (conn->from_port > MAXIMUM_PORT || conn->to_port > MAXIMUM_PORT ||
-                conn->from_port < MINIMUM_PORT || conn->to_port < MINIMUM_PORT) {
-                fprintf(stderr, "Port numbers %zu and/or %zu are too large\n", conn->from_port, conn->to_port);
-                exit(1);
-            }
-
-            pthread_mutex_lock(&port_array[conn->from_port].mutex);
-
-            while (packet_id != port_array[conn->from_port].last_packet_id + 1) {
-                pthread_cond_wait(&port_array[conn->from_port].signal, &port_array[conn->from_port].mutex);
-            }
-            // update packet id
-            port_array[conn->from_port].last_packet_id = packet_id;
-
-            // firewall: filter on port and "malicious" and decide if drop the message or not, if not , write to the file 
-            if (firewall(conn, contents, buffer_len - 3 * sizeof(size_t)) == 0) {
-                size_t write = forwarding(conn, // meta information: ports
-                                        &contents,  // buffer (contents)
-                                        (buffer_len - 3 * sizeof(size_t))); // buffer length
-                if (write != buffer_len - 3 * sizeof(size_t)) {
-                    // an error occured
-                    fprintf(stderr, "Error with forwarding\n");
-                }
-            }
-        // unlock packet id mutex
-        pthread_mutex_unlock(&port_array[conn->from_port].mutex);
-        // broadcast signal
-        pthread_cond_broadcast(&port_array[conn->from_port].signal);
-        }      
-        buffer_len = MESSAGE_SIZE + 1; 
-        memset(&buf, 0, buffer_len); // clearing buffer
-        memset(&contents, 0, buffer_len - 3 * sizeof(size_t)); // clearing contents array
+        // the batch is in ring order, so the oldest pending packet of every port is always processed first
+        for (size_t i = 0; i < count; i++) {
+            process_packet(conn, bufs[i], buffer_lens[i]);
+            buffer_lens[i] = sizeof(bufs[i]) - 1;
+        }
     } while(1);
 
     return NULL;
@@ -290,12 +358,34 @@ int simpledaemon(connection_t* connections, int nr_of_connections) {
     /* initialize ringbuffer */
     rbctx_t rb_ctx;
     size_t rbuf_size = 1024;
-    void *rbuf = malloc(rbuf_size);
-    if (rbuf == NULL) {
-        fprintf(stderr, "Error allocation ringbuffer\n");
+    void *rbuf = NULL; // only the last fallback below runs on caller memory
+
+    rbattr_t rb_attr;
+    ringbuffer_attr_init(&rb_attr);
+    rb_attr.mode = DAEMON_RING_MODE;
+    rb_attr.slot_size = MESSAGE_SIZE; // packets never exceed MESSAGE_SIZE
+    rb_attr.framing = DAEMON_RING_FRAMING;
+    rb_attr.combining = DAEMON_RING_COMBINING;
+    // the locked ring grows while bursts keep it full and shrinks back to rbuf_size when quiet
+    rbresize_t rb_resize;
+    ringbuffer_resize_init(&rb_resize);
+    rb_resize.max_size = DAEMON_RING_MAX_SIZE;
+    // the lock-free modes get a prefaulted mapping, so the first packets take no page faults
+    rbmem_t rb_mem;
+    ringbuffer_mem_init(&rb_mem);
+    rb_mem.prefault = 1;
+    if (rb_attr.mode != RB_MODE_LOCKED ||
+        ringbuffer_init_resizable(&rb_ctx, rbuf_size, &rb_attr, &rb_resize) != SUCCESS) {
+        if (ringbuffer_create(&rb_ctx, rbuf_size, &rb_attr, &rb_mem) != SUCCESS) {
+            rbuf = malloc(rbuf_size);
+            if (rbuf == NULL) {
+                fprintf(stderr, "Error allocation ringbuffer\n");
+                return 1;
+            }
+            ringbuffer_init_attr(&rb_ctx, rbuf, rbuf_size, &rb_attr);
+        }
     }
-
-    ringbuffer_init(&rb_ctx, rbuf, rbuf_size);
+    ringbuffer_enable_poll(&rb_ctx); // readers fall back to sleeping without it
 
     /****************************************************************
     * WRITER THREADS 
@@ -385,8 +475,7 @@ int simpledaemon(connection_t* connections, int nr_of_connections) {
 
     // use this section to free any memory, destory mutexe etc.
 
-    pthread_mutex_destroy(&rb_ctx.mtx);
-    pthread_cond_destroy(&rb_ctx.sig);
+    // the ringbuffer's own mutex and condition variables are released by ringbuffer_destroy below
 
     for (int i = 0; i < MAXIMUM_PORT+1; i++) {
         pthread_mutex_destroy(&file_mutex[i]);
@@ -1,4 +1,6 @@
+#define _GNU_SOURCE // memfd_create
 #include "../include/ringbuf.h"
+#include "ringbuf_wait.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -6,22 +8,308 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>  // For error handling
+#include <sched.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#endif
 
 
+static void mpmc_init(rbctx_t *context, size_t slot_size);
+
+// RB_MODE_SPSC and RB_MODE_TWOLOCK keep the ring in head and tail byte cursors
+static inline int spsc_cursors(const rbctx_t *context)
+{
+    return context->mode == RB_MODE_SPSC || context->mode == RB_MODE_TWOLOCK;
+}
+static void poll_arm(rbctx_t *context, rbevent_t *event, size_t message_len);
+
 void ringbuffer_init(rbctx_t *context, void *buffer_location, size_t buffer_size)
 {
+    ringbuffer_init_attr(context, buffer_location, buffer_size, NULL);
+}
+
+void ringbuffer_attr_init(rbattr_t *attr)
+{
+    attr->mode = RB_MODE_LOCKED;
+    attr->slot_size = RB_DEFAULT_SLOT_SIZE;
+    attr->wait = RB_WAIT_DEFAULT;
+    attr->framing = RB_FRAME_SIZE_T;
+    attr->overwrite = 0;
+    attr->combining = 0;
+}
+
+void ringbuffer_init_attr(rbctx_t *context, void *buffer_location, size_t buffer_size, const rbattr_t *attr)
+{
+    rbattr_t defaults;
+    if (attr == NULL) {
+        ringbuffer_attr_init(&defaults);
+        attr = &defaults;
+    }
+
     //  clear from begin till end 
     context->begin = buffer_location;
     context->end = buffer_location + buffer_size;
     context->read = buffer_location;
     context->write = buffer_location;
+    context->mode = attr->mode;
+    context->wait = attr->wait;
+    if (context->wait == RB_WAIT_DEFAULT) {
+        context->wait = (context->mode == RB_MODE_LOCKED || context->mode == RB_MODE_TWOLOCK) ?
+                        RB_WAIT_CONDVAR : RB_WAIT_SPIN_YIELD;
+    }
+    event_init(&context->data_event);
+    event_init(&context->space_event);
+    ringbuffer_reset_stats(context);
+    ringbuffer_reset_histograms(context);
+#ifdef RBUF_HISTOGRAMS
+    for (size_t i = 0; i < RB_HIST_STAMPS; i++) {
+        atomic_init(&context->stamps[i], 0);
+    }
+    context->stamps_written = 0;
+    context->stamps_read = 0;
+#endif
+    atomic_init(&context->head, 0);
+    atomic_init(&context->tail, 0);
+    context->tail_cache = 0;
+    context->head_cache = 0;
+    context->mask = 0;
+    if (spsc_cursors(context) && buffer_size > 0) {
+        // the largest power of two that fits, offsets are then cursor & mask
+        size_t capacity = 1;
+        while (capacity <= buffer_size / 2) {
+            capacity *= 2;
+        }
+        context->end = context->begin + capacity;
+        context->mask = capacity - 1;
+    }
+    context->slots = NULL;
+    context->slot_size = 0;
+    context->slot_stride = 0;
+    context->slot_count = 0;
+    context->storage = RB_STORAGE_USER;
+    context->map_size = 0;
+    context->busy_unlocks = 0;
+    context->idle_unlocks = 0;
+    context->shared = NULL;
+    context->lock = &context->mtx;
+    context->data_cond = &context->sig;
+    context->space_cond = &context->space;
+    context->framing = attr->framing;
+    context->overwrite = (context->mode == RB_MODE_LOCKED) && attr->overwrite;
+    context->combining = (context->mode == RB_MODE_LOCKED) && attr->combining;
+    atomic_init(&context->combine_list, NULL);
+    context->read_seq = 0;
+    if (context->mode == RB_MODE_MPMC) {
+        mpmc_init(context, attr->slot_size);
+    } else if (context->framing == RB_FRAME_FIXED) {
+        context->slot_size = attr->slot_size; // record size
+    }
 
 
-    // Initialize mutexes and condition variables
+    // Initialize mutexes and condition variables, timeouts are measured on CLOCK_MONOTONIC
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
     pthread_mutex_init(&context->mtx, NULL);
-    pthread_cond_init(&context->sig, NULL);
+    pthread_mutex_init(&context->read_mtx, NULL);
+    pthread_mutex_init(&context->write_mtx, NULL);
+    pthread_cond_init(&context->sig, &cond_attr);
+    pthread_cond_init(&context->space, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+}
+
+/*
+ * Returns a file descriptor for size bytes of anonymous shared memory.
+ * memfd_create is Linux-only, elsewhere a POSIX shm object is created and unlinked right away.
+ */
+static int mirror_fd(size_t size)
+{
+#ifdef __linux__
+    int fd = memfd_create("ringbuf", MFD_CLOEXEC);
+#else
+    static _Atomic unsigned counter;
+    char name[64];
+    snprintf(name, sizeof(name), "/ringbuf-%ld-%u", (long) getpid(), atomic_fetch_add(&counter, 1));
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        shm_unlink(name);
+    }
+#endif
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, size) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+int ringbuffer_init_mirrored(rbctx_t *context, size_t buffer_size, const rbattr_t *attr)
+{
+    // a power-of-two number of pages, so RB_MODE_SPSC can use all of it
+    size_t size = sysconf(_SC_PAGESIZE);
+    while (size < buffer_size) {
+        size *= 2;
+    }
+
+    int fd = mirror_fd(size);
+    if (fd < 0) {
+        return errno;
+    }
+    // reserve 2 * size of address space, then map the same pages over both halves
+    uint8_t *base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+    if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int err = errno;
+        munmap(base, 2 * size);
+        close(fd);
+        return err;
+    }
+    close(fd); // the mappings keep the memory alive
+
+    ringbuffer_init_attr(context, base, size, attr);
+    context->storage = RB_STORAGE_MIRRORED;
+    return SUCCESS;
+}
+
+#define RB_MAX_NUMA_NODES 1024
+
+void ringbuffer_mem_init(rbmem_t *mem)
+{
+    mem->pages = RB_PAGES_DEFAULT;
+    mem->huge_page_size = 0;
+    mem->prefault = 0;
+    mem->lock = 0;
+    mem->numa_node = -1;
+}
+
+/*
+ * Binds [addr, addr + len) to one NUMA node. Called before any page of it is touched,
+ * so every page is allocated on that node when it is first faulted in.
+ */
+static int create_bind(void *addr, size_t len, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long nodemask[RB_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+    const size_t bits = 8 * sizeof(unsigned long);
+    if (node >= RB_MAX_NUMA_NODES) {
+        return EINVAL;
+    }
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / bits] |= 1UL << (node % bits);
+    // the kernel ignores the last bit of maxnode, like numa_bind we pass one more
+    if (syscall(SYS_mbind, addr, len, MPOL_BIND, nodemask, (unsigned long) RB_MAX_NUMA_NODES + 1, 0) != 0) {
+        return errno;
+    }
+    return SUCCESS;
+#else
+    (void) addr;
+    (void) len;
+    (void) node;
+    return ENOSYS;
+#endif
+}
+
+int ringbuffer_create(rbctx_t *context, size_t buffer_size, const rbattr_t *attr, const rbmem_t *mem)
+{
+    rbmem_t defaults;
+    if (mem == NULL) {
+        ringbuffer_mem_init(&defaults);
+        mem = &defaults;
+    }
+    size_t base_page = sysconf(_SC_PAGESIZE);
+    size_t page = base_page;
+    if (mem->pages != RB_PAGES_DEFAULT) {
+        page = mem->huge_page_size ? mem->huge_page_size : RB_HUGE_PAGE_SIZE;
+    }
+    if (buffer_size == 0 || mem->numa_node < -1 || page < base_page || (page & (page - 1)) != 0) {
+        return EINVAL;
+    }
+
+    size_t size = buffer_size;
+    if (attr != NULL && (attr->mode == RB_MODE_SPSC || attr->mode == RB_MODE_TWOLOCK)) {
+        // the cursor modes only use the largest power of two that fits
+        size = 1;
+        while (size < buffer_size) {
+            size *= 2;
+        }
+    }
+    size = (size + page - 1) & ~(page - 1);
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t map_len = size;
+    if (mem->pages == RB_PAGES_HUGETLB) {
+#ifdef MAP_HUGETLB
+        flags |= MAP_HUGETLB;
+        if (mem->huge_page_size != 0) {
+            flags |= __builtin_ctzl(page) << MAP_HUGE_SHIFT;
+        }
+#else
+        return ENOTSUP;
+#endif
+    } else if (mem->pages == RB_PAGES_TRANSPARENT) {
+        map_len += page; // room to align the start to a huge page
+    }
+    uint8_t *base = mmap(NULL, map_len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED) {
+        return errno;
+    }
+
+    uint8_t *buffer = base;
+    if (mem->pages == RB_PAGES_TRANSPARENT) {
+        // keep the huge page aligned part, the kernel only backs aligned ranges with huge pages
+        buffer = (uint8_t *)(((uintptr_t) base + page - 1) & ~(uintptr_t)(page - 1));
+        if (buffer > base) {
+            munmap(base, buffer - base);
+        }
+        if (base + map_len > buffer + size) {
+            munmap(buffer + size, base + map_len - (buffer + size));
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(buffer, size, MADV_HUGEPAGE); // fails if THP is disabled, base pages then
+#endif
+    }
+
+    int err = SUCCESS;
+    if (mem->numa_node >= 0) {
+        err = create_bind(buffer, size, mem->numa_node);
+    }
+    if (err == SUCCESS && mem->prefault) {
+        // one write per base page, reads would only map the shared zero page
+        for (size_t i = 0; i < size; i += base_page) {
+            ((volatile uint8_t *) buffer)[i] = 0;
+        }
+    }
+    if (err == SUCCESS && mem->lock && mlock(buffer, size) != 0) {
+        err = errno;
+    }
+    if (err != SUCCESS) {
+        munmap(buffer, size);
+        return err;
+    }
+
+    ringbuffer_init_attr(context, buffer, size, attr);
+    context->storage = RB_STORAGE_MAPPED;
+    context->map_size = size;
+    return SUCCESS;
 }
 
+
 size_t available_space(rbctx_t *context) {
        return (context->write > context->read) ?
                              (context->write - context->read) :
@@ -29,23 +317,209 @@ size_t available_space(rbctx_t *context) {
 }
 
 
-int msg_size_copy(rbctx_t *context, size_t message_len) {
-    // helfer function for copying size_t_arr
-    
-    size_t SIZE = sizeof(size_t);
+/*
+ * Position len bytes after pos on a mirrored ring, wrapped back into [begin, end).
+ */
+static uint8_t *mirror_advance(rbctx_t *context, uint8_t *pos, size_t len)
+{
+    pos += len;
+    return (pos >= context->end) ? pos - (context->end - context->begin) : pos;
+}
+
+/*
+ * Copies len bytes from src into the ring starting at pos. The transfer is split
+ * into at most two contiguous segments: one up to end and one from begin.
+ * A mirrored ring always takes a single memcpy, the second mapping absorbs the wrap.
+ * Returns the position after the last written byte (wrapped to begin at end).
+ */
+static uint8_t *ring_put(rbctx_t *context, uint8_t *pos, const void *src, size_t len)
+{
+    if (context->storage == RB_STORAGE_MIRRORED) {
+        memcpy(pos, src, len);
+        return mirror_advance(context, pos, len);
+    }
+    if (pos == context->end) {
+        pos = context->begin;
+    }
+    size_t first = context->end - pos;
+    if (len < first) {
+        memcpy(pos, src, len);
+        return pos + len;
+    }
+    memcpy(pos, src, first);
+    memcpy(context->begin, (const uint8_t *)src + first, len - first);
+    return context->begin + (len - first);
+}
+
+/*
+ * Counterpart of ring_put: copies len bytes starting at pos out of the ring into dst.
+ */
+static uint8_t *ring_get(rbctx_t *context, uint8_t *pos, void *dst, size_t len)
+{
+    if (context->storage == RB_STORAGE_MIRRORED) {
+        memcpy(dst, pos, len);
+        return mirror_advance(context, pos, len);
+    }
+    if (pos == context->end) {
+        pos = context->begin;
+    }
+    size_t first = context->end - pos;
+    if (len < first) {
+        memcpy(dst, pos, len);
+        return pos + len;
+    }
+    memcpy(dst, pos, first);
+    memcpy((uint8_t *)dst + first, context->begin, len - first);
+    return context->begin + (len - first);
+}
 
-    char *size_t_arr = (char *)&message_len; // Cast the address of message_len to a char pointer for byte-wise access
+// -------------------- FRAMING -------------------- //
 
-    for (size_t i = 0; i < SIZE; i++) {
-        if (context->write == context->end) { // Check if the write pointer is at the end of the buffer
-            context->write = context->begin; // Wrap around to the beginning
+/*
+ * Bytes of the length header in front of a message_len byte message.
+ */
+static size_t frame_header_len(const rbctx_t *context, size_t message_len)
+{
+    switch (context->framing) {
+    case RB_FRAME_U16:
+        return sizeof(uint16_t);
+    case RB_FRAME_U32:
+        return sizeof(uint32_t);
+    case RB_FRAME_VARINT: {
+        size_t n = 1;
+        while (message_len >= 0x80) {
+            message_len >>= 7;
+            n++;
         }
-        memcpy(context->write, size_t_arr + i, 1); // Copy one byte at a time
-        context->write++; // Increment the write pointer
+        return n;
+    }
+    case RB_FRAME_FIXED:
+        return 0;
+    default:
+        return sizeof(size_t);
+    }
+}
+
+/*
+ * Bytes a message_len byte message occupies in the ring, header included.
+ */
+static size_t frame_len(const rbctx_t *context, size_t message_len)
+{
+    if (context->framing == RB_FRAME_FIXED) {
+        return context->slot_size;
+    }
+    return frame_header_len(context, message_len) + message_len;
+}
+
+/*
+ * Largest message the header can describe.
+ */
+static size_t frame_max_len(const rbctx_t *context)
+{
+    switch (context->framing) {
+    case RB_FRAME_U16:
+        return UINT16_MAX;
+    case RB_FRAME_U32:
+        return UINT32_MAX;
+    case RB_FRAME_FIXED:
+        return context->slot_size;
+    default:
+        return SIZE_MAX;
+    }
+}
+
+/*
+ * Writes the header of a message_len byte message at pos using exactly header_len bytes.
+ * A varint wider than needed (a reservation committed with less) is padded with
+ * continuation bytes. Returns the position of the message.
+ */
+static uint8_t *frame_put_header(rbctx_t *context, uint8_t *pos, size_t message_len, size_t header_len)
+{
+    uint8_t header[16];
+    switch (context->framing) {
+    case RB_FRAME_U16: {
+        uint16_t len = message_len;
+        memcpy(header, &len, sizeof(len));
+        break;
+    }
+    case RB_FRAME_U32: {
+        uint32_t len = message_len;
+        memcpy(header, &len, sizeof(len));
+        break;
     }
-    if (context->write == context->end) { // Check if the write pointer is at the end of the buffer
-            context->write = context->begin; // Wrap around to the beginning
+    case RB_FRAME_VARINT:
+        for (size_t i = 0; i < header_len; i++) {
+            header[i] = (message_len & 0x7f) | (i + 1 < header_len ? 0x80 : 0);
+            message_len >>= 7;
         }
+        break;
+    case RB_FRAME_FIXED:
+        return pos;
+    default:
+        memcpy(header, &message_len, sizeof(size_t));
+        break;
+    }
+    return ring_put(context, pos, header, header_len);
+}
+
+/*
+ * Reads the header at pos. Returns the position of the message.
+ */
+static uint8_t *frame_get_header(rbctx_t *context, uint8_t *pos, size_t *message_len)
+{
+    switch (context->framing) {
+    case RB_FRAME_U16: {
+        uint16_t len;
+        pos = ring_get(context, pos, &len, sizeof(len));
+        *message_len = len;
+        return pos;
+    }
+    case RB_FRAME_U32: {
+        uint32_t len;
+        pos = ring_get(context, pos, &len, sizeof(len));
+        *message_len = len;
+        return pos;
+    }
+    case RB_FRAME_VARINT: {
+        size_t len = 0;
+        unsigned shift = 0;
+        uint8_t byte;
+        do {
+            pos = ring_get(context, pos, &byte, 1);
+            if (shift < 64) {
+                len |= (size_t)(byte & 0x7f) << shift;
+            }
+            shift += 7;
+        } while (byte & 0x80);
+        *message_len = len;
+        return pos;
+    }
+    case RB_FRAME_FIXED:
+        *message_len = context->slot_size;
+        return pos;
+    default:
+        return ring_get(context, pos, message_len, sizeof(size_t));
+    }
+}
+
+/*
+ * RB_FRAME_FIXED: zero-fills the rest of the record behind a message_len byte message at pos.
+ */
+static uint8_t *frame_pad(rbctx_t *context, uint8_t *pos, size_t message_len)
+{
+    static const uint8_t zeros[64];
+    size_t left = context->slot_size - message_len;
+    while (left > 0) {
+        size_t n = left < sizeof(zeros) ? left : sizeof(zeros);
+        pos = ring_put(context, pos, zeros, n);
+        left -= n;
+    }
+    return pos;
+}
+
+int msg_size_copy(rbctx_t *context, size_t message_len) {
+    // writes the length header in front of the message
+    context->write = frame_put_header(context, context->write, message_len, frame_header_len(context, message_len));
     return 0; // successful process
 }
 
@@ -61,33 +535,9 @@ int msg_size_read(rbctx_t *context, size_t *message_len) {
         return EINVAL;
     }    
 
-    size_t SIZE = sizeof(size_t); // 8 byte
-
     size_t buffer_len_local = context->end - context->begin;
 
-    size_t prefix = SIZE;
-
-    size_t bytes_copied = 0;
-    while (prefix > 0) 
-    {
-        if (context->read >= context->end) {
-            context->read = context->begin; // Wrap around if at the end
-        }
-        // Safe copying with boundary checks
-        if ((char*)message_len + bytes_copied < (char*)message_len + sizeof(size_t)) {
-            memcpy((char*)message_len + bytes_copied, context->read, 1); // Copy one byte at a time
-            bytes_copied++;
-        } else {
-            // buffer overflow attempt
-            break;
-        }
-
-        context->read++;
-        if (context->read >= context->end) {
-            context->read = context->begin; // Additional safety check for read increment
-        }
-        prefix--;
-    }
+    context->read = frame_get_header(context, context->read, message_len);
    
     if (*message_len > buffer_len_local)  // ring buffer length
     {
@@ -100,7 +550,7 @@ int msg_size_read(rbctx_t *context, size_t *message_len) {
 
 size_t static is_buffer_full(rbctx_t *context, size_t msg_len) {
     u_int8_t *read = context->read;
-    size_t needed_space = msg_len + sizeof(size_t);
+    size_t needed_space = frame_len(context, msg_len);
     size_t ringbuffer_size = context->end - context->begin;
     size_t free_bytes = 0;
 
@@ -126,152 +576,2100 @@ int is_buffer_empty(rbctx_t *context) {
     uint8_t* local_write = context->write;
     uint8_t* begin = context->begin;
     uint8_t* end = context->end;
+    size_t min_frame = frame_len(context, 0); // a header alone, or one record
     // 1 = empty
     if (local_read == local_write) return 1; // buffer is empty
     // case if: context->read < context->write (check if still 8 bytes available?)
-    else if ( local_write > local_read) return (local_write - local_read) < 8; //(check if still 8 bytes available?)
+    else if ( local_write > local_read) return (size_t)(local_write - local_read) < min_frame; //(check if still a frame available?)
     else {
         size_t size_wrap = ((end - local_read) + (local_write - begin));
-        return size_wrap < 8; // wraparound case
+        return size_wrap < min_frame; // wraparound case
     } 
 
 }
 
-int ringbuffer_write(rbctx_t *context, void *message, size_t message_len)
+/*
+ * Bytes in use in the locked ring, headers included.
+ */
+static size_t locked_used(const rbctx_t *context)
 {
-    pthread_mutex_lock(&context->mtx);
-    
-    // setting timeout
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += 1; // Wait for up to 1 second
-
-    while (is_buffer_full(context, message_len)) { // buffer is still full
-        int res = pthread_cond_timedwait(&context->sig, &context->mtx, &ts);
- 
-        if (res == ETIMEDOUT) {
-        // Handle timeout scenario
-
-            pthread_mutex_unlock(&context->mtx);  // Unlock before returning
-            return RINGBUFFER_FULL;
-        }
+    return (context->write >= context->read) ?
+               (size_t)(context->write - context->read) :
+               (size_t)((context->end - context->read) + (context->write - context->begin));
+}
 
+// -------------------- STATISTICS -------------------- //
+
+static void stat_add(rbctx_t *context, _Atomic uint64_t *counter, uint64_t value)
+{
+    if (context->mode == RB_MODE_SPSC) {
+        // only one thread updates each side, a plain store does not lose updates
+        atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                              memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
     }
-    void *message_start = message; // remembers the start of message
-    // iterate till the message length is 0
-    msg_size_copy(context, message_len);
-    
-    
-    while (message_len > 0 && context->write != context->read) {
-     
-        if (context->write == context->end)  // check if the pointer inside the array -> else go to begin
-        {
-            context->write = context->begin;
+}
+
+static void stat_high_water(rbctx_t *context, uint64_t used)
+{
+    _Atomic uint64_t *mark = &context->write_stats.high_water;
+    uint64_t seen = atomic_load_explicit(mark, memory_order_relaxed);
+    while (used > seen &&
+           !atomic_compare_exchange_weak_explicit(mark, &seen, used, memory_order_relaxed, memory_order_relaxed));
+}
+
+/*
+ * Counts the outcome of a public write call and returns res. messages and bytes are
+ * only counted on SUCCESS. After RINGBUFFER_FULL bytes is the length of the message
+ * that did not fit, the space fd is armed for it.
+ */
+static int stats_write(rbctx_t *context, int res, size_t messages, size_t bytes)
+{
+    rbcounters_t *counters = &context->write_stats;
+    if (res == SUCCESS) {
+        if (messages > 0) {
+            stat_add(context, &counters->messages, messages);
+            stat_add(context, &counters->bytes, bytes);
         }
-        memcpy(context->write, message, 1);
-        context->write++;
-        message++;
-        message_len--;
+    } else if (res == RINGBUFFER_FULL) {
+        stat_add(context, &counters->timeouts, 1);
+        poll_arm(context, &context->space_event, bytes);
+    } else if (res == OUTPUT_BUFFER_TOO_SMALL) {
+        stat_add(context, &counters->too_small, 1);
     }
+    return res;
+}
 
-    if (context->write == context->end)  // check if the pointer inside the array -> else go to begin
-    {
-        context->write = context->begin;
+/*
+ * Read side of stats_write.
+ */
+static int stats_read(rbctx_t *context, int res, size_t messages, size_t bytes)
+{
+    rbcounters_t *counters = &context->read_stats;
+    if (res == SUCCESS) {
+        if (messages > 0) {
+            stat_add(context, &counters->messages, messages);
+            stat_add(context, &counters->bytes, bytes);
+        }
+    } else if (res == RINGBUFFER_EMPTY) {
+        stat_add(context, &counters->timeouts, 1);
+        poll_arm(context, &context->data_event, 0);
+    } else if (res == OUTPUT_BUFFER_TOO_SMALL) {
+        stat_add(context, &counters->too_small, 1);
     }
-    
-    message = message_start; // puts the message pointer to it's initial state
-    pthread_cond_signal(&context->sig); // signal to reader
-    pthread_mutex_unlock(&context->mtx);
-    return SUCCESS;
+    return res;
+}
 
+void ringbuffer_get_stats(rbctx_t *context, rbstats_t *stats)
+{
+    rbcounters_t *w = &context->write_stats;
+    rbcounters_t *r = &context->read_stats;
+    stats->messages_written = atomic_load_explicit(&w->messages, memory_order_relaxed);
+    stats->bytes_written = atomic_load_explicit(&w->bytes, memory_order_relaxed);
+    stats->messages_read = atomic_load_explicit(&r->messages, memory_order_relaxed);
+    stats->bytes_read = atomic_load_explicit(&r->bytes, memory_order_relaxed);
+    stats->full_timeouts = atomic_load_explicit(&w->timeouts, memory_order_relaxed);
+    stats->empty_timeouts = atomic_load_explicit(&r->timeouts, memory_order_relaxed);
+    stats->too_small = atomic_load_explicit(&w->too_small, memory_order_relaxed) +
+                       atomic_load_explicit(&r->too_small, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&w->high_water, memory_order_relaxed);
+    stats->write_wait_ns = atomic_load_explicit(&w->wait_ns, memory_order_relaxed);
+    stats->read_wait_ns = atomic_load_explicit(&r->wait_ns, memory_order_relaxed);
+    stats->grows = atomic_load_explicit(&w->resizes, memory_order_relaxed);
+    stats->shrinks = atomic_load_explicit(&r->resizes, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&w->dropped, memory_order_relaxed);
 }
 
-int ringbuffer_read(rbctx_t *context, void *buffer, size_t *buffer_len)
+void ringbuffer_reset_stats(rbctx_t *context)
 {
-    
-    pthread_mutex_lock(&context->mtx);
+    rbcounters_t *sides[] = {&context->write_stats, &context->read_stats};
+    for (int i = 0; i < 2; i++) {
+        atomic_store_explicit(&sides[i]->messages, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->timeouts, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->too_small, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->wait_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->high_water, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->resizes, 0, memory_order_relaxed);
+        atomic_store_explicit(&sides[i]->dropped, 0, memory_order_relaxed);
+    }
+}
 
-    if (!buffer || !buffer_len || *buffer_len == 0) { // safety check for buffer len
-        // Handle error
-        printf("Invalid buffer or context\n");
-        pthread_mutex_unlock(&context->mtx);
+// -------------------- HISTOGRAMS -------------------- //
 
-        return OUTPUT_BUFFER_TOO_SMALL;
+#ifdef RBUF_HISTOGRAMS
+// low bits of a side-ring entry: the message it belongs to, the rest is the write time
+#define RB_HIST_SEQ_BITS 16
+#define RB_HIST_SEQ_MASK ((UINT64_C(1) << RB_HIST_SEQ_BITS) - 1)
+
+static uint64_t hist_clock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static size_t hist_bucket(uint64_t value)
+{
+    if (value < (UINT64_C(1) << RB_HIST_SUB_BITS)) {
+        return value;
     }
+    int exponent = 63 - __builtin_clzll(value);
+    size_t sub = (value >> (exponent - RB_HIST_SUB_BITS)) & ((1u << RB_HIST_SUB_BITS) - 1);
+    return ((size_t)(exponent - RB_HIST_SUB_BITS + 1) << RB_HIST_SUB_BITS) + sub;
+}
 
+/*
+ * Highest value that falls into bucket i.
+ */
+static uint64_t hist_bucket_high(size_t i)
+{
+    if (i < (1u << RB_HIST_SUB_BITS)) {
+        return i;
+    }
+    int shift = (int)(i >> RB_HIST_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)((1u << RB_HIST_SUB_BITS) + (i & ((1u << RB_HIST_SUB_BITS) - 1))) << shift;
+    return low + ((UINT64_C(1) << shift) - 1);
+}
 
-    // -------------------- EMPTY BUFFER HANDLER -------------------- //
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts); // set timer start time
-    ts.tv_sec += 1; // set timer end time
-    while (is_buffer_empty(context)) // empty buffer condition
-    {  
- 
-        if (pthread_cond_timedwait(&context->sig, &context->mtx, &ts) == ETIMEDOUT) 
-        {
-            pthread_mutex_unlock(&context->mtx);  // Unlock mutex before returning
-            return RINGBUFFER_EMPTY; 
-        }
+static void hist_record(rbctx_t *context, rbhist_kind_t kind, uint64_t value)
+{
+    rbhist_t *hist = &context->hist[kind];
+    atomic_fetch_add_explicit(&hist->buckets[hist_bucket(value)], 1, memory_order_relaxed);
+    uint64_t seen = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(&hist->max, &seen, value, memory_order_relaxed, memory_order_relaxed));
+}
+
+/*
+ * Stores the write time of message seq, before the message is published.
+ */
+static void hist_stamp(rbctx_t *context, size_t seq)
+{
+    atomic_store_explicit(&context->stamps[seq % RB_HIST_STAMPS],
+                          (hist_clock() << RB_HIST_SEQ_BITS) | (seq & RB_HIST_SEQ_MASK), memory_order_relaxed);
+}
+
+/*
+ * Records how long message seq stayed in the ring, unless a later write took its entry.
+ */
+static void hist_residency(rbctx_t *context, size_t seq)
+{
+    uint64_t entry = atomic_load_explicit(&context->stamps[seq % RB_HIST_STAMPS], memory_order_relaxed);
+    if ((entry & RB_HIST_SEQ_MASK) != (seq & RB_HIST_SEQ_MASK)) {
+        return;
     }
+    // the shifted clock drops its top bits, the difference wraps the same way
+    uint64_t now = hist_clock() << RB_HIST_SEQ_BITS;
+    hist_record(context, RB_HIST_RESIDENCY, (now - (entry & ~RB_HIST_SEQ_MASK)) >> RB_HIST_SEQ_BITS);
+}
 
-    // -------------------- DEFINE MESSAGE SIZE -------------------- //
+// RB_MODE_LOCKED and the cursor modes number their messages, RB_MODE_MPMC uses the slot position
+static void hist_written(rbctx_t *context)
+{
+    hist_stamp(context, context->stamps_written++);
+}
 
+static void hist_read(rbctx_t *context)
+{
+    hist_residency(context, context->stamps_read++);
+}
 
-    size_t msg_len = 0;
-    if (msg_size_read(context, &msg_len) != 0) {
+static void hist_dropped(rbctx_t *context)
+{
+    context->stamps_read++;
+}
 
-        pthread_mutex_unlock(&context->mtx);
-        return OUTPUT_BUFFER_TOO_SMALL; // Define appropriate error handling
+/*
+ * Called with mtx just acquired by a caller that is done waiting.
+ */
+static void hist_locked(rbctx_t *context)
+{
+    context->locked_at = hist_clock();
+}
+
+static void hist_unlocked(rbctx_t *context)
+{
+    hist_record(context, RB_HIST_LOCK_HOLD, hist_clock() - context->locked_at);
+}
+
+int ringbuffer_get_histogram(rbctx_t *context, rbhist_kind_t kind, rbhist_summary_t *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    if ((unsigned)kind >= RB_HIST_KINDS) {
+        return EINVAL;
+    }
+    rbhist_t *hist = &context->hist[kind];
+    uint64_t counts[RB_HIST_BUCKETS];
+    uint64_t total = 0;
+    for (size_t i = 0; i < RB_HIST_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    summary->count = total;
+    summary->max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    if (total == 0) {
+        return SUCCESS;
     }
 
-    // -------------------- ENSURE BUFFER LEN IS NOT SMALLER THAN MESSAGE SIZE -------------------- //
+    const uint64_t permille[] = {500, 990, 999};
+    uint64_t *out[] = {&summary->p50, &summary->p99, &summary->p999};
+    for (int q = 0; q < 3; q++) {
+        uint64_t rank = (total * permille[q] + 999) / 1000; // values at or below the percentile
+        uint64_t seen = counts[0];
+        size_t i = 0;
+        while (seen < rank && i < RB_HIST_BUCKETS - 1) {
+            seen += counts[++i];
+        }
+        uint64_t high = hist_bucket_high(i);
+        *out[q] = high < summary->max ? high : summary->max;
+    }
+    return SUCCESS;
+}
 
-    if (*buffer_len < msg_len) {
-        
-        pthread_mutex_unlock(&context->mtx);  // Unlock mutex before returning
-        *buffer_len = 0;
-        return OUTPUT_BUFFER_TOO_SMALL; 
+void ringbuffer_reset_histograms(rbctx_t *context)
+{
+    for (int kind = 0; kind < RB_HIST_KINDS; kind++) {
+        atomic_store_explicit(&context->hist[kind].max, 0, memory_order_relaxed);
+        for (size_t i = 0; i < RB_HIST_BUCKETS; i++) {
+            atomic_store_explicit(&context->hist[kind].buckets[i], 0, memory_order_relaxed);
+        }
     }
+}
+#else
+static inline void hist_record(rbctx_t *context, rbhist_kind_t kind, uint64_t value)
+{
+    (void)context; (void)kind; (void)value;
+}
 
-    // -------------------- COPY MESSAGE LEN BYTE FOR BYTE INTO BUFFER -------------------- //
-    // Use a separate pointer for traversing the buffer
-    char *buffer_ptr = buffer;
+static inline void hist_stamp(rbctx_t *context, size_t seq) { (void)context; (void)seq; }
+static inline void hist_residency(rbctx_t *context, size_t seq) { (void)context; (void)seq; }
+static inline void hist_written(rbctx_t *context) { (void)context; }
+static inline void hist_read(rbctx_t *context) { (void)context; }
+static inline void hist_dropped(rbctx_t *context) { (void)context; }
+static inline void hist_locked(rbctx_t *context) { (void)context; }
+static inline void hist_unlocked(rbctx_t *context) { (void)context; }
 
-    size_t bytes_read = 0;
+int ringbuffer_get_histogram(rbctx_t *context, rbhist_kind_t kind, rbhist_summary_t *summary)
+{
+    (void)context;
+    memset(summary, 0, sizeof(*summary));
+    return (unsigned)kind >= RB_HIST_KINDS ? EINVAL : ENOTSUP;
+}
+
+void ringbuffer_reset_histograms(rbctx_t *context)
+{
+    (void)context;
+}
+#endif
+
+// -------------------- WAITING -------------------- //
+
+/*
+ * Adds the time since deadline_start to the wait time of one side, if the caller waited.
+ */
+static void deadline_finish(rbctx_t *context, const rbdeadline_t *deadline, rbcounters_t *counters)
+{
+    if (!deadline->started) {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t waited = (int64_t)(now.tv_sec - deadline->since.tv_sec) * 1000000000 +
+                     (now.tv_nsec - deadline->since.tv_nsec);
+    stat_add(context, &counters->wait_ns, (uint64_t)waited);
+    hist_record(context, RB_HIST_WAIT, (uint64_t)waited);
+}
 
+/*
+ * Signals the eventfd of event if a caller armed it. Only the notifier that clears armed
+ * writes to the fd, every other notification until the next arming is free.
+ */
+static void poll_signal(rbevent_t *event)
+{
+#ifdef __linux__
+    // pairs with the fence in poll_arm: either this sees armed, or the arming caller sees the change
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&event->armed, memory_order_relaxed) &&
+        atomic_exchange_explicit(&event->armed, 0, memory_order_relaxed)) {
+        eventfd_write(event->fd, 1);
+    }
+#else
+    (void)event;
+#endif
+}
 
-    while (msg_len > 0 && context->read != context->write) {
-        if (context->read >= context->end) {
-            context->read = context->begin; // Wrap around
+/*
+ * Wakes one (or all) of the threads waiting for event. Called after the change they
+ * wait for has been published; in RB_MODE_LOCKED with the mutex held.
+ */
+static void event_notify(rbctx_t *context, rbevent_t *event, pthread_cond_t *cond, int all)
+{
+    if (event->fd >= 0) {
+        poll_signal(event);
+    }
+    if (context->mode == RB_MODE_LOCKED && context->wait == RB_WAIT_CONDVAR) {
+        if (all) {
+            pthread_cond_broadcast(cond);
+        } else {
+            pthread_cond_signal(cond);
         }
+        return;
+    }
+    if (context->mode != RB_MODE_LOCKED &&
+        (context->wait == RB_WAIT_SPIN || context->wait == RB_WAIT_SPIN_YIELD)) {
+        return; // spinning waiters poll the cursors themselves
+    }
+
+    // in RB_MODE_LOCKED the caller holds the mutex already
+    event_wake(event, context->wait, context->mode == RB_MODE_LOCKED ? NULL : context->lock, cond, all);
+}
 
-        *buffer_ptr = *context->read; // Copy data to the buffer
-        context->read++;
-        buffer_ptr++;
-        msg_len--;
-        bytes_read++; // 33
+// -------------------- SPSC MODE -------------------- //
+
+/*
+ * Describes len bytes starting at pos as (at most) two contiguous segments.
+ * Returns the position after the region.
+ */
+static uint8_t *ring_span(rbctx_t *context, uint8_t *pos, size_t len, rbspan_t *span)
+{
+    if (context->storage == RB_STORAGE_MIRRORED) {
+        span->ptr[0] = pos;
+        span->len[0] = len;
+        span->ptr[1] = NULL;
+        span->len[1] = 0;
+        return mirror_advance(context, pos, len);
     }
-    
-    if (context->read >= context->end) {
-        context->read = context->begin; // Wrap around
+    if (pos == context->end) {
+        pos = context->begin;
+    }
+    size_t first = context->end - pos;
+    span->ptr[0] = pos;
+    if (len < first) {
+        span->len[0] = len;
+        span->ptr[1] = NULL;
+        span->len[1] = 0;
+        return pos + len;
     }
+    span->len[0] = first;
+    span->ptr[1] = (len > first) ? context->begin : NULL;
+    span->len[1] = len - first;
+    return context->begin + (len - first);
+}
 
-    *buffer_len = bytes_read;
-    pthread_cond_signal(&context->sig); // signal to writer
-    pthread_mutex_unlock(&context->mtx);
+static uint8_t *ring_advance(rbctx_t *context, uint8_t *pos, size_t len)
+{
+    if (pos == context->end) {
+        pos = context->begin;
+    }
+    size_t first = context->end - pos;
+    return (len < first) ? pos + len : context->begin + (len - first);
+}
 
-    return SUCCESS;
-    
+/*
+ * head and tail count the bytes ever read and written, tail - head bytes are in use
+ * and cursor & mask is the offset of a cursor in the buffer.
+ */
+static uint8_t *spsc_at(rbctx_t *context, size_t cursor)
+{
+    return context->begin + (cursor & context->mask);
 }
 
-void ringbuffer_destroy(rbctx_t *context)
+/*
+ * Cursor behind the frame at cursor, given where frame_get_header found its message.
+ * The header width is taken from memory, a committed varint may be wider than needed.
+ */
+static size_t spsc_next(rbctx_t *context, size_t cursor, uint8_t *frame, uint8_t *msg, size_t msg_len)
 {
-    /* your solution here */
+    return cursor + ((size_t)(msg - frame) & context->mask) + msg_len;
+}
+
+/*
+ * Waits until the writer owning tail sees needed_space free bytes. head is only reloaded
+ * (from the reader's cache line) when the last value seen is not enough.
+ */
+static int spsc_wait_space(rbctx_t *context, size_t needed_space, size_t *tail_ptr, int64_t timeout_ns)
+{
+    size_t capacity = context->mask + 1;
+    // only this thread moves tail, the reader publishes head
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_relaxed);
+    if (context->begin == context->end || needed_space > capacity) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+    if (capacity - (tail - context->head_cache) >= needed_space) {
+        *tail_ptr = tail;
+        return SUCCESS;
+    }
+
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    for (;;) {
+        uint32_t seen = event_seq(&context->space_event);
+        context->head_cache = atomic_load_explicit(&context->head, memory_order_acquire);
+        if (capacity - (tail - context->head_cache) >= needed_space) {
+            break;
+        }
+        if (wait_step(&context->space_event, context->wait, context->lock, context->space_cond, seen, &deadline) == ETIMEDOUT) {
+            deadline_finish(context, &deadline, &context->write_stats);
+            return RINGBUFFER_FULL;
+        }
+    }
+    deadline_finish(context, &deadline, &context->write_stats);
+    *tail_ptr = tail;
+    return SUCCESS;
+}
+
+/*
+ * Waits until at least one frame has been published by the writer. Like the writer,
+ * the reader only reloads tail when its cached value says the ring is empty.
+ */
+static int spsc_wait_data(rbctx_t *context, size_t *head_ptr, int64_t timeout_ns)
+{
+    // only this thread moves head, the writer publishes tail
+    size_t head = atomic_load_explicit(&context->head, memory_order_relaxed);
+    *head_ptr = head;
+    if (context->tail_cache != head) {
+        return SUCCESS;
+    }
+
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    for (;;) {
+        uint32_t seen = event_seq(&context->data_event);
+        context->tail_cache = atomic_load_explicit(&context->tail, memory_order_acquire);
+        if (context->tail_cache != head) {
+            break;
+        }
+        if (wait_step(&context->data_event, context->wait, context->lock, context->data_cond, seen, &deadline) == ETIMEDOUT) {
+            deadline_finish(context, &deadline, &context->read_stats);
+            return RINGBUFFER_EMPTY;
+        }
+    }
+    deadline_finish(context, &deadline, &context->read_stats);
+    return SUCCESS;
+}
+
+/*
+ * Raises the high-water mark after the writer moved tail. head_cache may be stale and
+ * overstate the occupancy, so head is reloaded before the mark goes up.
+ */
+static void spsc_high_water(rbctx_t *context, size_t tail)
+{
+    if (tail - context->head_cache > atomic_load_explicit(&context->write_stats.high_water, memory_order_relaxed)) {
+        context->head_cache = atomic_load_explicit(&context->head, memory_order_acquire);
+        stat_high_water(context, tail - context->head_cache);
+    }
+}
+
+static int spsc_write(rbctx_t *context, const void *message, size_t message_len, int64_t timeout_ns)
+{
+    size_t tail;
+    if (message_len > frame_max_len(context) ||
+        spsc_wait_space(context, frame_len(context, message_len), &tail, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_FULL;
+    }
+
+    uint8_t *pos = frame_put_header(context, spsc_at(context, tail), message_len, frame_header_len(context, message_len));
+    pos = ring_put(context, pos, message, message_len);
+    if (context->framing == RB_FRAME_FIXED) {
+        frame_pad(context, pos, message_len);
+    }
+    hist_written(context);
+    // publish the whole frame at once
+    tail += frame_len(context, message_len);
+    atomic_store_explicit(&context->tail, tail, memory_order_release);
+    event_notify(context, &context->data_event, context->data_cond, 0);
+    spsc_high_water(context, tail);
+    return SUCCESS;
+}
+
+static int spsc_read(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns)
+{
+    if (!buffer || !buffer_len || *buffer_len == 0) {
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+
+    size_t head;
+    if (spsc_wait_data(context, &head, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_EMPTY;
+    }
+
+    size_t msg_len;
+    uint8_t *frame = spsc_at(context, head);
+    uint8_t *pos = frame_get_header(context, frame, &msg_len);
+    if (*buffer_len < msg_len) {
+        // leave the message in the ring so a larger buffer can pick it up
+        *buffer_len = 0;
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+    ring_get(context, pos, buffer, msg_len);
+    *buffer_len = msg_len;
+    hist_read(context);
+    // hand the space back to the writer after the copy is done
+    atomic_store_explicit(&context->head, spsc_next(context, head, frame, pos, msg_len), memory_order_release);
+    event_notify(context, &context->space_event, context->space_cond, 0);
+    return SUCCESS;
+}
+
+// -------------------- TWO-LOCK MODE -------------------- //
+
+/*
+ * The SPSC cursors with one writer and one reader at a time. Each side's cache (head_cache,
+ * tail_cache) is handed from one thread to the next by its mutex, the other side is only
+ * seen through the published cursor.
+ */
+static int twolock_write(rbctx_t *context, const void *message, size_t message_len, int64_t timeout_ns)
+{
+    pthread_mutex_lock(&context->write_mtx);
+    int res = spsc_write(context, message, message_len, timeout_ns);
+    pthread_mutex_unlock(&context->write_mtx);
+    return res;
+}
+
+static int twolock_read(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns)
+{
+    pthread_mutex_lock(&context->read_mtx);
+    int res = spsc_read(context, buffer, buffer_len, timeout_ns);
+    pthread_mutex_unlock(&context->read_mtx);
+    return res;
+}
+
+// -------------------- MPMC MODE -------------------- //
+
+/*
+ * Bounded MPMC queue after Dmitry Vyukov: slot i starts with seq == i. A writer may fill
+ * the slot for position pos once seq == pos and publishes it with seq = pos + 1, a reader
+ * may take it once seq == pos + 1 and hands it back with seq = pos + slot_count.
+ */
+typedef struct {
+    _Atomic size_t seq;
+    size_t len;
+    uint8_t data[];
+} rbslot_t;
+
+// length of a slot whose reservation was canceled, readers skip it
+#define RB_SLOT_SKIP SIZE_MAX
+
+static void mpmc_init(rbctx_t *context, size_t slot_size)
+{
+    uintptr_t first = ((uintptr_t)context->begin + RB_CACHE_LINE - 1) & ~(uintptr_t)(RB_CACHE_LINE - 1);
+    size_t stride = (sizeof(rbslot_t) + slot_size + RB_CACHE_LINE - 1) & ~(size_t)(RB_CACHE_LINE - 1);
+
+    context->slots = (uint8_t *)first;
+    context->slot_size = slot_size;
+    context->slot_stride = stride;
+    context->slot_count = (first + stride <= (uintptr_t)context->end) ?
+                              ((uintptr_t)context->end - first) / stride : 0;
+
+    for (size_t i = 0; i < context->slot_count; i++) {
+        rbslot_t *slot = (rbslot_t *)(context->slots + i * stride);
+        atomic_init(&slot->seq, i);
+        slot->len = 0;
+    }
+}
+
+static rbslot_t *mpmc_slot(rbctx_t *context, size_t pos)
+{
+    return (rbslot_t *)(context->slots + (pos % context->slot_count) * context->slot_stride);
+}
+
+/*
+ * Claims the next free slot for a writer. The slot belongs to the caller until
+ * mpmc_publish hands it to the readers.
+ */
+static int mpmc_claim_write(rbctx_t *context, size_t message_len, int64_t timeout_ns,
+                            size_t *pos_ptr, rbslot_t **slot_ptr)
+{
+    if (context->slot_count == 0 || message_len > context->slot_size) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    rbslot_t *slot;
+    size_t pos = atomic_load_explicit(&context->tail, memory_order_relaxed);
+    for (;;) {
+        uint32_t seen = event_seq(&context->space_event);
+        slot = mpmc_slot(context, pos);
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // slot is free for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&context->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the reader of the previous lap has not released this slot yet: full
+            if (wait_step(&context->space_event, context->wait, context->lock, context->space_cond, seen, &deadline) == ETIMEDOUT) {
+                deadline_finish(context, &deadline, &context->write_stats);
+                return RINGBUFFER_FULL;
+            }
+            pos = atomic_load_explicit(&context->tail, memory_order_relaxed);
+        } else {
+            // another writer claimed it first
+            pos = atomic_load_explicit(&context->tail, memory_order_relaxed);
+        }
+    }
+    deadline_finish(context, &deadline, &context->write_stats);
+    *pos_ptr = pos;
+    *slot_ptr = slot;
+    return SUCCESS;
+}
+
+static void mpmc_publish(rbctx_t *context, rbslot_t *slot, size_t pos, size_t message_len)
+{
+    if (message_len != RB_SLOT_SKIP) {
+        // before the slot is handed over head cannot pass pos
+        size_t head = atomic_load_explicit(&context->head, memory_order_relaxed);
+        stat_high_water(context, (uint64_t)(pos + 1 - head) * context->slot_stride);
+        hist_stamp(context, pos);
+    }
+    slot->len = message_len;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    event_notify(context, &context->data_event, context->data_cond, 0);
+}
+
+static void mpmc_release(rbctx_t *context, rbslot_t *slot, size_t pos)
+{
+    hist_residency(context, pos); // canceled reservations have no stamp and are skipped
+    atomic_store_explicit(&slot->seq, pos + context->slot_count, memory_order_release);
+    event_notify(context, &context->space_event, context->space_cond, 0);
+}
+
+/*
+ * Claims the oldest written slot for a reader. Messages longer than max_len are left
+ * in place, canceled reservations are skipped. An empty ring waits up to timeout_ns.
+ */
+static int mpmc_claim_read(rbctx_t *context, size_t max_len, int64_t timeout_ns,
+                           size_t *pos_ptr, rbslot_t **slot_ptr)
+{
+    if (context->slot_count == 0) {
+        return RINGBUFFER_EMPTY;
+    }
+
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    rbslot_t *slot;
+    size_t pos = atomic_load_explicit(&context->head, memory_order_relaxed);
+    for (;;) {
+        uint32_t seen = event_seq(&context->data_event);
+        slot = mpmc_slot(context, pos);
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            // len is stable until someone claims pos, so check it before the CAS
+            size_t len = slot->len;
+            if (len != RB_SLOT_SKIP && len > max_len) {
+                deadline_finish(context, &deadline, &context->read_stats);
+                return OUTPUT_BUFFER_TOO_SMALL;
+            }
+            if (atomic_compare_exchange_weak_explicit(&context->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                if (len != RB_SLOT_SKIP) {
+                    break;
+                }
+                mpmc_release(context, slot, pos);
+                pos++;
+            }
+        } else if (diff < 0) {
+            // not written yet: empty
+            if (wait_step(&context->data_event, context->wait, context->lock, context->data_cond, seen, &deadline) == ETIMEDOUT) {
+                deadline_finish(context, &deadline, &context->read_stats);
+                return RINGBUFFER_EMPTY;
+            }
+            pos = atomic_load_explicit(&context->head, memory_order_relaxed);
+        } else {
+            // another reader took it first
+            pos = atomic_load_explicit(&context->head, memory_order_relaxed);
+        }
+    }
+    deadline_finish(context, &deadline, &context->read_stats);
+    *pos_ptr = pos;
+    *slot_ptr = slot;
+    return SUCCESS;
+}
+
+static int mpmc_write(rbctx_t *context, const void *message, size_t message_len, int64_t timeout_ns)
+{
+    size_t pos;
+    rbslot_t *slot;
+    if (mpmc_claim_write(context, message_len, timeout_ns, &pos, &slot) != SUCCESS) {
+        return RINGBUFFER_FULL;
+    }
+    memcpy(slot->data, message, message_len);
+    mpmc_publish(context, slot, pos, message_len);
+    return SUCCESS;
+}
+
+static int mpmc_read(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns)
+{
+    if (!buffer || !buffer_len || *buffer_len == 0) {
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+
+    size_t pos;
+    rbslot_t *slot;
+    int res = mpmc_claim_read(context, *buffer_len, timeout_ns, &pos, &slot);
+    if (res != SUCCESS) {
+        if (res == OUTPUT_BUFFER_TOO_SMALL) {
+            *buffer_len = 0;
+        }
+        return res;
+    }
+
+    size_t msg_len = slot->len;
+    memcpy(buffer, slot->data, msg_len);
+    *buffer_len = msg_len;
+    mpmc_release(context, slot, pos);
+    return SUCCESS;
+}
+
+// -------------------- SHARED STORAGE -------------------- //
+
+#define RB_SHARED_MAGIC UINT64_C(0x314d485346554252) // "RBUFSHM1"
+
+/*
+ * Start of a process-shared ring. Everything the processes share lives in here and
+ * positions are offsets from the ring data, so every process may map it elsewhere.
+ */
+struct rbshared {
+    _Atomic uint64_t magic; // stored last by the creator
+    size_t map_size;        // bytes of the object, header included
+    size_t data_offset;     // where the ring data starts, cache-line aligned
+    size_t data_size;
+    rbframing_t framing;
+    size_t slot_size;       // RB_FRAME_FIXED record size
+    int overwrite;
+    size_t read;            // offset of the next frame to read, only touched with mtx held
+    uint64_t read_seq;      // likewise
+    size_t write;           // offset where the next frame goes, likewise
+    pthread_mutex_t mtx;    // process-shared and robust
+    pthread_cond_t sig;     // process-shared, readers wait here for data
+    pthread_cond_t space;   // process-shared, writers wait here for space
+};
+
+/*
+ * Sets context up as this process' view of a mapped shared ring.
+ */
+static void shared_view(rbctx_t *context, struct rbshared *shared, const rbattr_t *attr)
+{
+    ringbuffer_init_attr(context, (uint8_t *)shared + shared->data_offset, shared->data_size, attr);
+    context->storage = RB_STORAGE_SHARED;
+    context->shared = shared;
+    context->lock = &shared->mtx;
+    context->data_cond = &shared->sig;
+    context->space_cond = &shared->space;
+}
+
+/*
+ * read and write of a shared ring are loaded whenever this process gets the mutex and
+ * published before it lets go of it.
+ */
+static void shared_load(rbctx_t *context)
+{
+    if (context->shared != NULL) {
+        context->read = context->begin + context->shared->read;
+        context->write = context->begin + context->shared->write;
+        context->read_seq = context->shared->read_seq;
+    }
+}
+
+static void shared_store(rbctx_t *context)
+{
+    if (context->shared != NULL) {
+        context->shared->read = context->read - context->begin;
+        context->shared->write = context->write - context->begin;
+        context->shared->read_seq = context->read_seq;
+    }
+}
+
+int ringbuffer_create_shared(rbctx_t *context, const char *name, size_t buffer_size, const rbattr_t *attr)
+{
+    rbattr_t shared_attr;
+    if (attr == NULL) {
+        ringbuffer_attr_init(&shared_attr);
+    } else {
+        shared_attr = *attr;
+    }
+    shared_attr.mode = RB_MODE_LOCKED;
+    shared_attr.wait = RB_WAIT_CONDVAR;
+
+    size_t data_offset = (sizeof(struct rbshared) + RB_CACHE_LINE - 1) & ~(size_t)(RB_CACHE_LINE - 1);
+    size_t map_size = data_offset + buffer_size;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return errno;
+    }
+    struct rbshared *shared = MAP_FAILED;
+    if (ftruncate(fd, map_size) == 0) {
+        shared = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (shared == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        shm_unlink(name);
+        return err;
+    }
+    close(fd); // the mapping keeps the object alive
+
+    // the object is zero-filled, so attach sees no magic until everything is set up
+    shared->map_size = map_size;
+    shared->data_offset = data_offset;
+    shared->data_size = buffer_size;
+    shared->framing = shared_attr.framing;
+    shared->slot_size = shared_attr.slot_size;
+    shared->overwrite = shared_attr.overwrite;
+    shared->read = 0;
+    shared->write = 0;
+    shared->read_seq = 0;
+
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&shared->mtx, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&shared->sig, &cond_attr);
+    pthread_cond_init(&shared->space, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    atomic_store_explicit(&shared->magic, RB_SHARED_MAGIC, memory_order_release);
+    shared_view(context, shared, &shared_attr);
+    return SUCCESS;
+}
+
+int ringbuffer_attach_shared(rbctx_t *context, const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+    size_t map_size = st.st_size;
+    if (map_size < sizeof(struct rbshared)) {
+        close(fd);
+        return EINVAL;
+    }
+    struct rbshared *shared = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (shared == MAP_FAILED) {
+        return err;
+    }
+    if (atomic_load_explicit(&shared->magic, memory_order_acquire) != RB_SHARED_MAGIC ||
+        shared->map_size != map_size) {
+        munmap(shared, map_size);
+        return EINVAL;
+    }
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_LOCKED;
+    attr.wait = RB_WAIT_CONDVAR;
+    attr.framing = shared->framing;
+    attr.slot_size = shared->slot_size;
+    attr.overwrite = shared->overwrite;
+    shared_view(context, shared, &attr);
+    return SUCCESS;
+}
+
+int ringbuffer_unlink_shared(const char *name)
+{
+    return shm_unlink(name) == 0 ? SUCCESS : errno;
+}
+
+// -------------------- RESIZABLE STORAGE -------------------- //
+
+void ringbuffer_resize_init(rbresize_t *policy)
+{
+    policy->min_size = 0;
+    policy->max_size = 0;
+    policy->grow_at = 75;
+    policy->grow_after = 8;
+    policy->shrink_at = 25;
+    policy->shrink_after = 1024;
+    policy->on_resize = NULL;
+    policy->arg = NULL;
+}
+
+int ringbuffer_init_resizable(rbctx_t *context, size_t buffer_size, const rbattr_t *attr, const rbresize_t *policy)
+{
+    rbattr_t locked_attr;
+    if (attr == NULL) {
+        ringbuffer_attr_init(&locked_attr);
+    } else {
+        locked_attr = *attr;
+    }
+    locked_attr.mode = RB_MODE_LOCKED;
+
+    rbresize_t resize;
+    if (policy == NULL) {
+        ringbuffer_resize_init(&resize);
+    } else {
+        resize = *policy;
+    }
+    if (resize.min_size == 0) {
+        resize.min_size = buffer_size;
+    }
+    if (resize.max_size == 0) {
+        resize.max_size = buffer_size * 64;
+    }
+    if (buffer_size == 0 || buffer_size < resize.min_size || buffer_size > resize.max_size) {
+        return EINVAL;
+    }
+
+    uint8_t *buffer = malloc(buffer_size);
+    if (buffer == NULL) {
+        return ENOMEM;
+    }
+    ringbuffer_init_attr(context, buffer, buffer_size, &locked_attr);
+    context->storage = RB_STORAGE_HEAP;
+    context->resize = resize;
+    return SUCCESS;
+}
+
+/*
+ * Moves the messages of the ring, oldest first, to the start of a new buffer of
+ * buffer_size bytes. Called with the mutex held, the caller checked that they fit.
+ */
+static int resize_to(rbctx_t *context, size_t buffer_size)
+{
+    size_t old_size = context->end - context->begin;
+    size_t used = locked_used(context);
+    uint8_t *buffer = malloc(buffer_size);
+    if (buffer == NULL) {
+        return ENOMEM;
+    }
+    ring_get(context, context->read, buffer, used);
+    free(context->begin);
+    context->begin = buffer;
+    context->end = buffer + buffer_size;
+    context->read = buffer;
+    context->write = buffer + used;
+    context->busy_unlocks = 0;
+    context->idle_unlocks = 0;
+
+    if (buffer_size > old_size) {
+        stat_add(context, &context->write_stats.resizes, 1);
+        event_notify(context, &context->space_event, context->space_cond, 1); // every waiting writer may fit now
+    } else {
+        stat_add(context, &context->read_stats.resizes, 1);
+    }
+    if (context->resize.on_resize != NULL) {
+        context->resize.on_resize(context->resize.arg, old_size, buffer_size);
+    }
+    return SUCCESS;
+}
+
+/*
+ * Grows a full ring, with the mutex held, until message_len plus its header fit or
+ * max_size is reached. Returns SUCCESS if the message fits now.
+ */
+static int resize_grow(rbctx_t *context, size_t message_len)
+{
+    size_t size = context->end - context->begin;
+    size_t needed = locked_used(context) + frame_len(context, message_len) + 1; // is_buffer_full keeps a byte free
+    if (context->storage != RB_STORAGE_HEAP || size >= context->resize.max_size || needed > context->resize.max_size) {
+        return RINGBUFFER_FULL;
+    }
+    while (size < needed) {
+        size = (size > context->resize.max_size / 2) ? context->resize.max_size : size * 2;
+    }
+    return resize_to(context, size) == SUCCESS ? SUCCESS : RINGBUFFER_FULL;
+}
+
+/*
+ * Applies the policy when a caller unlocks the ring: doubles it after grow_after busy
+ * unlocks in a row, halves it after shrink_after idle ones.
+ */
+static void resize_check(rbctx_t *context)
+{
+    const rbresize_t *policy = &context->resize;
+    size_t size = context->end - context->begin;
+    size_t used = locked_used(context);
+    if (used * 100 >= size * policy->grow_at) {
+        context->idle_unlocks = 0;
+        if (++context->busy_unlocks >= policy->grow_after && size < policy->max_size) {
+            resize_to(context, (size > policy->max_size / 2) ? policy->max_size : size * 2);
+        }
+    } else if (used * 100 < size * policy->shrink_at) {
+        context->busy_unlocks = 0;
+        size_t smaller = (size / 2 < policy->min_size) ? policy->min_size : size / 2;
+        // the smaller ring must not count as busy right away
+        if (++context->idle_unlocks >= policy->shrink_after && smaller < size &&
+            used * 100 < smaller * policy->grow_at) {
+            resize_to(context, smaller);
+        }
+    } else {
+        context->busy_unlocks = 0;
+        context->idle_unlocks = 0;
+    }
+}
+
+int ringbuffer_resize(rbctx_t *context, size_t buffer_size)
+{
+    if (context->storage != RB_STORAGE_HEAP || buffer_size < context->resize.min_size ||
+        buffer_size > context->resize.max_size) {
+        return EINVAL;
+    }
+    pthread_mutex_lock(context->lock);
+    int res = SUCCESS;
+    if (locked_used(context) >= buffer_size) {
+        res = EBUSY;
+    } else if (buffer_size != (size_t)(context->end - context->begin)) {
+        res = resize_to(context, buffer_size);
+    }
+    pthread_mutex_unlock(context->lock);
+    return res;
+}
+
+// -------------------- LOCKED MODE -------------------- //
+
+/*
+ * Locks the ring. The mutex of a shared ring is robust: if its owner died, the next caller
+ * gets EOWNERDEAD and takes it over. Positions are only published at unlock and by
+ * locked_drop_oldest, so the ring is then still as it was before the dead owner's
+ * operation, less the messages it dropped.
+ */
+static void locked_lock(rbctx_t *context)
+{
+    if (pthread_mutex_lock(context->lock) == EOWNERDEAD) {
+        pthread_mutex_consistent(context->lock);
+    }
+    shared_load(context);
+}
+
+/*
+ * One round of waiting for event with the mutex held. RB_WAIT_CONDVAR sleeps on cond,
+ * the other strategies drop the mutex while they wait for event->seq to move (it is only
+ * bumped with the mutex held). Returns with the mutex held, ETIMEDOUT once the deadline
+ * has passed.
+ */
+static int locked_wait_step(rbctx_t *context, rbevent_t *event, pthread_cond_t *cond, rbdeadline_t *deadline)
+{
+    if (context->wait == RB_WAIT_CONDVAR) {
+        if (deadline->timeout_ns == RB_TIMEOUT_TRY) {
+            return ETIMEDOUT;
+        }
+        deadline_start(deadline);
+        int res = (deadline->timeout_ns < 0) ? pthread_cond_wait(cond, context->lock) :
+                                               pthread_cond_timedwait(cond, context->lock, &deadline->at);
+        if (res == EOWNERDEAD) {
+            // shared ring, a process died holding the mutex (see locked_lock)
+            pthread_mutex_consistent(context->lock);
+            res = SUCCESS;
+        }
+        shared_load(context);
+        return res;
+    }
+
+    uint32_t seen = atomic_load_explicit(&event->seq, memory_order_relaxed);
+    pthread_mutex_unlock(context->lock);
+    int res;
+    do {
+        res = wait_step(event, context->wait, context->lock, cond, seen, deadline);
+    } while (res == SUCCESS && atomic_load_explicit(&event->seq, memory_order_relaxed) == seen);
+    locked_lock(context);
+    return res;
+}
+
+/*
+ * Unlocks the ring after a successful locked_wait_space or locked_wait_data.
+ */
+static void locked_unlock(rbctx_t *context)
+{
+    if (context->storage == RB_STORAGE_HEAP) {
+        resize_check(context);
+    }
+    hist_unlocked(context);
+    shared_store(context);
+    pthread_mutex_unlock(context->lock);
+}
+
+/*
+ * Drops the oldest message of an overwrite ring, with the mutex held. Returns 0 if
+ * the ring is empty. A shared ring publishes the drop at once: the new frame goes over
+ * the dropped bytes, and a process that dies while copying it must not leave read there.
+ */
+static int locked_drop_oldest(rbctx_t *context)
+{
+    if (is_buffer_empty(context)) {
+        return 0;
+    }
+    size_t msg_len;
+    uint8_t *pos = frame_get_header(context, context->read, &msg_len);
+    context->read = ring_advance(context, pos, msg_len); // RB_FRAME_FIXED reports slot_size
+    context->read_seq++;
+    hist_dropped(context);
+    stat_add(context, &context->write_stats.dropped, 1);
+    shared_store(context);
+    return 1;
+}
+
+/*
+ * Makes room for message_len plus its prefix without waiting, with the mutex held: by
+ * growing a resizable ring or, in an overwrite ring, by dropping old messages unless the
+ * message would not even fit into the empty ring. Returns 0 if it still doesn't fit.
+ */
+static int locked_make_room(rbctx_t *context, size_t message_len)
+{
+    while (is_buffer_full(context, message_len)) {
+        if (resize_grow(context, message_len) == SUCCESS) {
+            return 1;
+        }
+        if (!context->overwrite || frame_len(context, message_len) >= (size_t)(context->end - context->begin) ||
+            !locked_drop_oldest(context)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Locks the ring and waits until message_len plus its prefix fit. An overwrite ring
+ * drops old messages instead of waiting.
+ * Returns with the mutex held on SUCCESS and released on RINGBUFFER_FULL.
+ */
+static int locked_wait_space(rbctx_t *context, size_t message_len, int64_t timeout_ns)
+{
+    locked_lock(context);
+
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    while (!locked_make_room(context, message_len)) { // buffer is still full
+        if (context->overwrite) {
+            pthread_mutex_unlock(context->lock);
+            return RINGBUFFER_FULL;
+        }
+        if (locked_wait_step(context, &context->space_event, context->space_cond, &deadline) == ETIMEDOUT) {
+            pthread_mutex_unlock(context->lock);  // Unlock before returning
+            deadline_finish(context, &deadline, &context->write_stats);
+            return RINGBUFFER_FULL;
+        }
+    }
+    deadline_finish(context, &deadline, &context->write_stats);
+    hist_locked(context);
+    return SUCCESS;
+}
+
+/*
+ * Locks the ring and waits until a message is available.
+ * Returns with the mutex held on SUCCESS and released on RINGBUFFER_EMPTY.
+ */
+static int locked_wait_data(rbctx_t *context, int64_t timeout_ns)
+{
+    locked_lock(context);
+
+    // -------------------- EMPTY BUFFER HANDLER -------------------- //
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    while (is_buffer_empty(context)) // empty buffer condition
+    {
+        if (locked_wait_step(context, &context->data_event, context->data_cond, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(context->lock);  // Unlock mutex before returning
+            deadline_finish(context, &deadline, &context->read_stats);
+            return RINGBUFFER_EMPTY;
+        }
+    }
+    deadline_finish(context, &deadline, &context->read_stats);
+    hist_locked(context);
+    return SUCCESS;
+}
+
+/*
+ * Copies one message to the write position, with the mutex held and room made for it.
+ */
+static void locked_put(rbctx_t *context, const void *message, size_t message_len)
+{
+    msg_size_copy(context, message_len);
+    context->write = ring_put(context, context->write, message, message_len);
+    hist_written(context);
+    if (context->framing == RB_FRAME_FIXED) {
+        context->write = frame_pad(context, context->write, message_len);
+    }
+}
+
+static int locked_write(rbctx_t *context, void *message, size_t message_len, int64_t timeout_ns)
+{
+    if (message_len > frame_max_len(context)) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+    if (locked_wait_space(context, message_len, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_FULL;
+    }
+    locked_put(context, message, message_len);
+
+    event_notify(context, &context->data_event, context->data_cond, 0); // signal to reader
+    stat_high_water(context, locked_used(context));
+    locked_unlock(context);
+    return SUCCESS;
+
+}
+
+// -------------------- COMBINING WRITES -------------------- //
+
+#define RB_COMBINE_POSTED 0   // waiting for a lock holder
+#define RB_COMBINE_DONE 1     // copied into the ring
+#define RB_COMBINE_REJECTED 2 // did not fit, the writer takes it back
+#define RB_COMBINE_PASSES 4   // rounds a lock holder takes over the list before it lets go
+
+/*
+ * A write posted by a writer of a combining ring. It lives on the writer's stack until
+ * state leaves RB_COMBINE_POSTED, the lock holder must not touch it after that.
+ */
+struct rbcombine {
+    const void *message;
+    size_t message_len;
+    struct rbcombine *next;
+    _Atomic int state;
+};
+
+static int locked_trylock(rbctx_t *context)
+{
+    int res = pthread_mutex_trylock(context->lock);
+    if (res == EOWNERDEAD) {
+        pthread_mutex_consistent(context->lock); // see locked_lock
+        res = SUCCESS;
+    }
+    if (res != SUCCESS) {
+        return 0;
+    }
+    shared_load(context);
+    return 1;
+}
+
+/*
+ * Applies the posted writes in the order they were posted, with the mutex held, and
+ * unlocks. written counts what the caller already wrote in this critical section. Once
+ * one of them doesn't fit, the later ones are rejected too, so a long message is not
+ * overtaken by a stream of short ones while its writer waits for space.
+ */
+static void combine_apply(rbctx_t *context, size_t written)
+{
+    int full = 0;
+    for (int pass = 0; pass < RB_COMBINE_PASSES; pass++) {
+        struct rbcombine *list = atomic_exchange_explicit(&context->combine_list, NULL, memory_order_acquire);
+        if (list == NULL) {
+            break;
+        }
+        struct rbcombine *oldest = NULL;
+        while (list != NULL) { // the list is newest first
+            struct rbcombine *next = list->next;
+            list->next = oldest;
+            oldest = list;
+            list = next;
+        }
+        while (oldest != NULL) {
+            struct rbcombine *next = oldest->next;
+            int state = RB_COMBINE_REJECTED;
+            if (!full && locked_make_room(context, oldest->message_len)) {
+                locked_put(context, oldest->message, oldest->message_len);
+                written++;
+                state = RB_COMBINE_DONE;
+            } else {
+                full = 1;
+            }
+            atomic_store_explicit(&oldest->state, state, memory_order_release);
+            oldest = next;
+        }
+    }
+    if (written > 0) {
+        event_notify(context, &context->data_event, context->data_cond, written > 1);
+        stat_high_water(context, locked_used(context));
+    }
+    locked_unlock(context);
+}
+
+/*
+ * Posts the message and waits until a lock holder applied it, or becomes the lock holder
+ * itself: spinning on trylock for RB_SPIN_LIMIT rounds, then sleeping on the mutex.
+ */
+static int combine_write(rbctx_t *context, void *message, size_t message_len, int64_t timeout_ns)
+{
+    if (message_len > frame_max_len(context)) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+    // the fallbacks to locked_write only get what the spinning left of the timeout
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    deadline_start(&deadline);
+    // nobody to combine with and the mutex free: write directly
+    if (atomic_load_explicit(&context->combine_list, memory_order_relaxed) == NULL && locked_trylock(context)) {
+        hist_locked(context);
+        if (locked_make_room(context, message_len)) {
+            locked_put(context, message, message_len);
+            combine_apply(context, 1);
+            return SUCCESS;
+        }
+        combine_apply(context, 0);
+        return locked_write(context, message, message_len, deadline_remaining(&deadline));
+    }
+
+    struct rbcombine post = {.message = message, .message_len = message_len};
+    atomic_init(&post.state, RB_COMBINE_POSTED);
+    post.next = atomic_load_explicit(&context->combine_list, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&context->combine_list, &post.next, &post,
+                                                  memory_order_release, memory_order_relaxed));
+
+    // a lock holder that takes the list after we posted applies us before it unlocks
+    for (unsigned spins = 0; atomic_load_explicit(&post.state, memory_order_acquire) == RB_COMBINE_POSTED; spins++) {
+        if (spins < RB_SPIN_LIMIT) {
+            if (locked_trylock(context)) {
+                hist_locked(context);
+                combine_apply(context, 0);
+            } else {
+                cpu_relax();
+            }
+        } else {
+            locked_lock(context);
+            hist_locked(context);
+            combine_apply(context, 0);
+        }
+    }
+    if (atomic_load_explicit(&post.state, memory_order_relaxed) == RB_COMBINE_DONE) {
+        return SUCCESS;
+    }
+    return locked_write(context, message, message_len, deadline_remaining(&deadline));
+}
+
+static int locked_read(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns, uint64_t *seq)
+{
+    if (!buffer || !buffer_len || *buffer_len == 0) { // safety check for buffer len
+        // Handle error
+        printf("Invalid buffer or context\n");
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+
+    if (locked_wait_data(context, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_EMPTY;
+    }
+
+    // -------------------- DEFINE MESSAGE SIZE -------------------- //
+
+
+    size_t msg_len = 0;
+    if (msg_size_read(context, &msg_len) != 0) {
+
+        locked_unlock(context);
+        return OUTPUT_BUFFER_TOO_SMALL; // Define appropriate error handling
+    }
+
+    // -------------------- ENSURE BUFFER LEN IS NOT SMALLER THAN MESSAGE SIZE -------------------- //
+
+    if (*buffer_len < msg_len) {
+        
+        locked_unlock(context);  // Unlock mutex before returning
+        *buffer_len = 0;
+        return OUTPUT_BUFFER_TOO_SMALL; 
+    }
+
+    // -------------------- COPY MESSAGE INTO BUFFER (AT MOST TWO SEGMENTS) -------------------- //
+    // never read past the write pointer, even if the prefix claims more
+    size_t used = locked_used(context);
+    size_t bytes_read = msg_len < used ? msg_len : used;
+
+    context->read = ring_get(context, context->read, buffer, bytes_read);
+    hist_read(context);
+    if (seq != NULL) {
+        *seq = context->read_seq;
+    }
+    context->read_seq++;
+
+    *buffer_len = bytes_read;
+    event_notify(context, &context->space_event, context->space_cond, 0); // signal to writer
+    locked_unlock(context);
+
+    return SUCCESS;
+    
+}
+
+int ringbuffer_write(rbctx_t *context, void *message, size_t message_len)
+{
+    return ringbuffer_write_timed(context, message, message_len, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_write_timed(rbctx_t *context, void *message, size_t message_len, int64_t timeout_ns)
+{
+    int res;
+    if (context->mode == RB_MODE_SPSC) {
+        res = spsc_write(context, message, message_len, timeout_ns);
+    } else if (context->mode == RB_MODE_TWOLOCK) {
+        res = twolock_write(context, message, message_len, timeout_ns);
+    } else if (context->mode == RB_MODE_MPMC) {
+        res = mpmc_write(context, message, message_len, timeout_ns);
+    } else if (context->combining) {
+        res = combine_write(context, message, message_len, timeout_ns);
+    } else {
+        res = locked_write(context, message, message_len, timeout_ns);
+    }
+    return stats_write(context, res, 1, message_len);
+}
+
+int ringbuffer_read(rbctx_t *context, void *buffer, size_t *buffer_len)
+{
+    return ringbuffer_read_timed(context, buffer, buffer_len, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_read_timed(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns)
+{
+    int res;
+    if (context->mode == RB_MODE_SPSC) {
+        res = spsc_read(context, buffer, buffer_len, timeout_ns);
+    } else if (context->mode == RB_MODE_TWOLOCK) {
+        res = twolock_read(context, buffer, buffer_len, timeout_ns);
+    } else if (context->mode == RB_MODE_MPMC) {
+        res = mpmc_read(context, buffer, buffer_len, timeout_ns);
+    } else {
+        res = locked_read(context, buffer, buffer_len, timeout_ns, NULL);
+    }
+    return stats_read(context, res, 1, res == SUCCESS ? *buffer_len : 0);
+}
+
+int ringbuffer_read_seq(rbctx_t *context, void *buffer, size_t *buffer_len, int64_t timeout_ns, uint64_t *seq)
+{
+    if (context->mode != RB_MODE_LOCKED) {
+        return ENOTSUP;
+    }
+    int res = locked_read(context, buffer, buffer_len, timeout_ns, seq);
+    return stats_read(context, res, 1, res == SUCCESS ? *buffer_len : 0);
+}
+
+// -------------------- POLLABLE READINESS -------------------- //
+
+/*
+ * Whether a reader would find a message right now. Lock-free modes only look at the
+ * cursors, a slot that is claimed but not yet published may count as data.
+ */
+static int poll_has_data(rbctx_t *context)
+{
+    if (spsc_cursors(context)) {
+        return atomic_load_explicit(&context->tail, memory_order_relaxed) !=
+               atomic_load_explicit(&context->head, memory_order_relaxed);
+    }
+    if (context->mode == RB_MODE_MPMC) {
+        if (context->slot_count == 0) {
+            return 0;
+        }
+        size_t head = atomic_load_explicit(&context->head, memory_order_relaxed);
+        size_t seq = atomic_load_explicit(&mpmc_slot(context, head)->seq, memory_order_relaxed);
+        return (intptr_t)seq - (intptr_t)(head + 1) >= 0; // published, or head moved on
+    }
+    pthread_mutex_lock(context->lock);
+    int res = !is_buffer_empty(context);
+    pthread_mutex_unlock(context->lock);
+    return res;
+}
+
+/*
+ * Whether a writer of message_len bytes would find space right now.
+ */
+static int poll_has_space(rbctx_t *context, size_t message_len)
+{
+    if (spsc_cursors(context)) {
+        if (context->begin == context->end || message_len > frame_max_len(context)) {
+            return 0;
+        }
+        size_t used = atomic_load_explicit(&context->tail, memory_order_relaxed) -
+                      atomic_load_explicit(&context->head, memory_order_relaxed);
+        return context->mask + 1 - used >= frame_len(context, message_len);
+    }
+    if (context->mode == RB_MODE_MPMC) {
+        if (context->slot_count == 0 || message_len > context->slot_size) {
+            return 0;
+        }
+        size_t tail = atomic_load_explicit(&context->tail, memory_order_relaxed);
+        size_t seq = atomic_load_explicit(&mpmc_slot(context, tail)->seq, memory_order_relaxed);
+        return (intptr_t)seq - (intptr_t)tail >= 0; // released, or tail moved on
+    }
+    if (message_len > frame_max_len(context)) {
+        return 0;
+    }
+    pthread_mutex_lock(context->lock);
+    int res = !is_buffer_full(context, message_len);
+    pthread_mutex_unlock(context->lock);
+    return res;
+}
+
+/*
+ * Arms the eventfd of event for a caller that is about to poll it: drains the fd, sets
+ * armed and checks the ring once more, so a change that the notifier published before
+ * it could see armed still signals the fd.
+ */
+static void poll_arm(rbctx_t *context, rbevent_t *event, size_t message_len)
+{
+    if (event->fd < 0) {
+        return;
+    }
+#ifdef __linux__
+    eventfd_t drained;
+    eventfd_read(event->fd, &drained); // EAGAIN if nothing was pending
+    atomic_store_explicit(&event->armed, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int ready = (event == &context->data_event) ? poll_has_data(context) : poll_has_space(context, message_len);
+    if (ready && atomic_exchange_explicit(&event->armed, 0, memory_order_relaxed)) {
+        eventfd_write(event->fd, 1);
+    }
+#else
+    (void)context;
+    (void)message_len;
+#endif
+}
+
+int ringbuffer_enable_poll(rbctx_t *context)
+{
+#ifdef __linux__
+    if (context->storage == RB_STORAGE_SHARED) {
+        return EINVAL;
+    }
+    if (context->data_event.fd >= 0) {
+        return SUCCESS;
+    }
+    int data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (data_fd < 0) {
+        return errno;
+    }
+    int space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (space_fd < 0) {
+        int err = errno;
+        close(data_fd);
+        return err;
+    }
+    context->data_event.fd = data_fd;
+    context->space_event.fd = space_fd;
+    poll_arm(context, &context->data_event, 0); // the ring may already hold messages
+    return SUCCESS;
+#else
+    (void)context;
+    return ENOTSUP;
+#endif
+}
+
+int ringbuffer_data_fd(const rbctx_t *context)
+{
+    return context->data_event.fd;
+}
+
+int ringbuffer_space_fd(const rbctx_t *context)
+{
+    return context->space_event.fd;
+}
+
+// -------------------- BATCHED READ -------------------- //
+
+/*
+ * A batch stops at max_messages, at the first message that does not fit its buffer and
+ * at the byte budget. The first message is always taken if it fits its buffer, so a
+ * budget smaller than one message cannot stall the reader.
+ */
+static int batch_accepts(size_t n, size_t bytes, size_t msg_len, size_t buffer_len, size_t max_bytes)
+{
+    if (msg_len > buffer_len) {
+        return 0;
+    }
+    return n == 0 || max_bytes == 0 || bytes + msg_len <= max_bytes;
+}
+
+static int spsc_read_batch(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                           size_t max_messages, size_t max_bytes, size_t *count, int64_t timeout_ns)
+{
+    size_t head;
+    if (spsc_wait_data(context, &head, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_EMPTY;
+    }
+    // take everything published so far
+    size_t tail = atomic_load_explicit(&context->tail, memory_order_acquire);
+    context->tail_cache = tail;
+
+    size_t n = 0, bytes = 0;
+    while (n < max_messages && head != tail) {
+        size_t msg_len;
+        uint8_t *frame = spsc_at(context, head);
+        uint8_t *pos = frame_get_header(context, frame, &msg_len);
+        if (!batch_accepts(n, bytes, msg_len, buffer_lens[n], max_bytes)) {
+            break;
+        }
+        ring_get(context, pos, buffers[n], msg_len);
+        hist_read(context);
+        head = spsc_next(context, head, frame, pos, msg_len);
+        buffer_lens[n++] = msg_len;
+        bytes += msg_len;
+    }
+    // one release for the whole batch
+    atomic_store_explicit(&context->head, head, memory_order_release);
+    if (n > 0) {
+        event_notify(context, &context->space_event, context->space_cond, 0);
+    }
+    *count = n;
+    return n > 0 ? SUCCESS : OUTPUT_BUFFER_TOO_SMALL;
+}
+
+static int mpmc_read_batch(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                           size_t max_messages, size_t max_bytes, size_t *count, int64_t timeout_ns)
+{
+    size_t n = 0, bytes = 0;
+    while (n < max_messages) {
+        size_t pos;
+        rbslot_t *slot;
+        size_t max_len = buffer_lens[n];
+        if (n > 0 && max_bytes != 0) {
+            size_t budget = (bytes < max_bytes) ? max_bytes - bytes : 0;
+            max_len = (budget < max_len) ? budget : max_len;
+        }
+        // only the first message may wait, the rest of the batch is whatever is ready
+        int res = mpmc_claim_read(context, max_len, n == 0 ? timeout_ns : RB_TIMEOUT_TRY, &pos, &slot);
+        if (res != SUCCESS) {
+            if (n == 0) {
+                return res;
+            }
+            break;
+        }
+        size_t msg_len = slot->len;
+        memcpy(buffers[n], slot->data, msg_len);
+        mpmc_release(context, slot, pos);
+        buffer_lens[n++] = msg_len;
+        bytes += msg_len;
+    }
+    *count = n;
+    return SUCCESS;
+}
+
+static int locked_read_batch(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                             size_t max_messages, size_t max_bytes, size_t *count, int64_t timeout_ns)
+{
+    if (locked_wait_data(context, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_EMPTY;
+    }
+
+    size_t n = 0, bytes = 0;
+    while (n < max_messages && !is_buffer_empty(context)) {
+        size_t msg_len;
+        // look at the prefix first, a message that is not taken stays in the ring
+        uint8_t *pos = frame_get_header(context, context->read, &msg_len);
+        if (!batch_accepts(n, bytes, msg_len, buffer_lens[n], max_bytes)) {
+            break;
+        }
+        context->read = ring_get(context, pos, buffers[n], msg_len);
+        hist_read(context);
+        context->read_seq++;
+        buffer_lens[n++] = msg_len;
+        bytes += msg_len;
+    }
+
+    if (n > 0) {
+        // a whole batch may make room for several writers
+        event_notify(context, &context->space_event, context->space_cond, 1);
+    }
+    locked_unlock(context);
+    *count = n;
+    return n > 0 ? SUCCESS : OUTPUT_BUFFER_TOO_SMALL;
+}
+
+int ringbuffer_read_batch(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                          size_t max_messages, size_t max_bytes, size_t *count)
+{
+    return ringbuffer_read_batch_timed(context, buffers, buffer_lens, max_messages, max_bytes, count,
+                                       RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_read_batch_timed(rbctx_t *context, void **buffers, size_t *buffer_lens,
+                                size_t max_messages, size_t max_bytes, size_t *count, int64_t timeout_ns)
+{
+    *count = 0;
+    if (!buffers || !buffer_lens || max_messages == 0) {
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+
+    int res;
+    if (context->mode == RB_MODE_SPSC) {
+        res = spsc_read_batch(context, buffers, buffer_lens, max_messages, max_bytes, count, timeout_ns);
+    } else if (context->mode == RB_MODE_TWOLOCK) {
+        pthread_mutex_lock(&context->read_mtx);
+        res = spsc_read_batch(context, buffers, buffer_lens, max_messages, max_bytes, count, timeout_ns);
+        pthread_mutex_unlock(&context->read_mtx);
+    } else if (context->mode == RB_MODE_MPMC) {
+        res = mpmc_read_batch(context, buffers, buffer_lens, max_messages, max_bytes, count, timeout_ns);
+    } else {
+        res = locked_read_batch(context, buffers, buffer_lens, max_messages, max_bytes, count, timeout_ns);
+    }
+    size_t bytes = 0;
+    for (size_t i = 0; i < *count; i++) {
+        bytes += buffer_lens[i];
+    }
+    return stats_read(context, res, *count, bytes);
+}
+
+size_t ringbuffer_used(rbctx_t *context)
+{
+    if (spsc_cursors(context) || context->mode == RB_MODE_MPMC) {
+        // head first: tail loaded after it is never behind it
+        size_t head = atomic_load_explicit(&context->head, memory_order_acquire);
+        size_t used = atomic_load_explicit(&context->tail, memory_order_acquire) - head;
+        return context->mode == RB_MODE_MPMC ? used * context->slot_size : used;
+    }
+    locked_lock(context);
+    size_t used = locked_used(context);
+    pthread_mutex_unlock(context->lock);
+    return used;
+}
+
+// -------------------- ZERO-COPY ACCESS -------------------- //
+
+static int ring_reserve(rbctx_t *context, size_t message_len, rbspan_t *span, int64_t timeout_ns)
+{
+    if (context->mode == RB_MODE_MPMC) {
+        rbslot_t *slot;
+        if (mpmc_claim_write(context, message_len, timeout_ns, &span->pos, &slot) != SUCCESS) {
+            return RINGBUFFER_FULL;
+        }
+        span->frame = (uint8_t *)slot;
+        span->ptr[0] = slot->data;
+        span->len[0] = message_len;
+        span->ptr[1] = NULL;
+        span->len[1] = 0;
+        return SUCCESS;
+    }
+
+    if (message_len > frame_max_len(context)) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+    uint8_t *frame;
+    if (spsc_cursors(context)) {
+        size_t tail;
+        if (context->mode == RB_MODE_TWOLOCK) {
+            pthread_mutex_lock(&context->write_mtx); // held until commit or cancel
+        }
+        if (spsc_wait_space(context, frame_len(context, message_len), &tail, timeout_ns) != SUCCESS) {
+            if (context->mode == RB_MODE_TWOLOCK) {
+                pthread_mutex_unlock(&context->write_mtx);
+            }
+            return RINGBUFFER_FULL;
+        }
+        span->pos = tail;
+        frame = spsc_at(context, tail);
+    } else {
+        // the mutex stays locked until commit or cancel
+        if (locked_wait_space(context, message_len, timeout_ns) != SUCCESS) {
+            return RINGBUFFER_FULL;
+        }
+        frame = context->write;
+    }
+    span->frame = frame;
+    ring_span(context, ring_advance(context, frame, frame_header_len(context, message_len)), message_len, span);
+    return SUCCESS;
+}
+
+int ringbuffer_write_reserve(rbctx_t *context, size_t message_len, rbspan_t *span)
+{
+    return ringbuffer_write_reserve_timed(context, message_len, span, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_write_reserve_timed(rbctx_t *context, size_t message_len, rbspan_t *span, int64_t timeout_ns)
+{
+    // counted as a write once committed
+    return stats_write(context, ring_reserve(context, message_len, span, timeout_ns), 0, message_len);
+}
+
+int ringbuffer_write_commit(rbctx_t *context, rbspan_t *span, size_t message_len)
+{
+    if (message_len > span->len[0] + span->len[1]) {
+        ringbuffer_write_cancel(context, span);
+        return stats_write(context, OUTPUT_BUFFER_TOO_SMALL, 0, 0);
+    }
+    stats_write(context, SUCCESS, 1, message_len);
+
+    if (context->mode == RB_MODE_MPMC) {
+        mpmc_publish(context, (rbslot_t *)span->frame, span->pos, message_len);
+        return SUCCESS;
+    }
+
+    // the prefix is written last, with the final length but as wide as reserved
+    size_t header_len = frame_header_len(context, span->len[0] + span->len[1]);
+    uint8_t *pos = frame_put_header(context, span->frame, message_len, header_len);
+    pos = ring_advance(context, pos, message_len);
+    if (context->framing == RB_FRAME_FIXED) {
+        pos = frame_pad(context, pos, message_len);
+    }
+    hist_written(context);
+    if (spsc_cursors(context)) {
+        size_t frame_bytes = header_len + (context->framing == RB_FRAME_FIXED ? context->slot_size : message_len);
+        atomic_store_explicit(&context->tail, span->pos + frame_bytes, memory_order_release);
+        event_notify(context, &context->data_event, context->data_cond, 0);
+        spsc_high_water(context, span->pos + frame_bytes);
+        if (context->mode == RB_MODE_TWOLOCK) {
+            pthread_mutex_unlock(&context->write_mtx);
+        }
+        return SUCCESS;
+    }
+    context->write = pos;
+    event_notify(context, &context->data_event, context->data_cond, 0); // signal to reader
+    stat_high_water(context, locked_used(context));
+    locked_unlock(context);
+    return SUCCESS;
+}
+
+void ringbuffer_write_cancel(rbctx_t *context, rbspan_t *span)
+{
+    if (context->mode == RB_MODE_MPMC) {
+        // the slot is already claimed, readers skip it
+        mpmc_publish(context, (rbslot_t *)span->frame, span->pos, RB_SLOT_SKIP);
+    } else if (context->mode == RB_MODE_LOCKED) {
+        locked_unlock(context);
+    } else if (context->mode == RB_MODE_TWOLOCK) {
+        pthread_mutex_unlock(&context->write_mtx);
+    }
+}
+
+/*
+ * Peeks at the next message if it is at most max_len bytes long. A longer message is
+ * left untouched (and the locked ring unlocked again).
+ */
+static int ring_peek(rbctx_t *context, size_t max_len, rbspan_t *span, int64_t timeout_ns)
+{
+    if (context->mode == RB_MODE_MPMC) {
+        rbslot_t *slot;
+        int res = mpmc_claim_read(context, max_len, timeout_ns, &span->pos, &slot);
+        if (res != SUCCESS) {
+            return res;
+        }
+        span->frame = (uint8_t *)slot;
+        span->ptr[0] = slot->data;
+        span->len[0] = slot->len;
+        span->ptr[1] = NULL;
+        span->len[1] = 0;
+        return SUCCESS;
+    }
+
+    uint8_t *frame;
+    size_t head = 0;
+    if (spsc_cursors(context)) {
+        if (context->mode == RB_MODE_TWOLOCK) {
+            pthread_mutex_lock(&context->read_mtx); // held until release
+        }
+        if (spsc_wait_data(context, &head, timeout_ns) != SUCCESS) {
+            if (context->mode == RB_MODE_TWOLOCK) {
+                pthread_mutex_unlock(&context->read_mtx);
+            }
+            return RINGBUFFER_EMPTY;
+        }
+        frame = spsc_at(context, head);
+    } else {
+        // the mutex stays locked until release
+        if (locked_wait_data(context, timeout_ns) != SUCCESS) {
+            return RINGBUFFER_EMPTY;
+        }
+        frame = context->read;
+    }
+
+    size_t msg_len;
+    uint8_t *pos = frame_get_header(context, frame, &msg_len);
+    if (msg_len > max_len) {
+        if (context->mode == RB_MODE_LOCKED) {
+            locked_unlock(context);
+        } else if (context->mode == RB_MODE_TWOLOCK) {
+            pthread_mutex_unlock(&context->read_mtx);
+        }
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+    span->frame = ring_span(context, pos, msg_len, span); // where the next frame starts
+    if (spsc_cursors(context)) {
+        span->pos = spsc_next(context, head, frame, pos, msg_len);
+    }
+    return SUCCESS;
+}
+
+int ringbuffer_read_peek(rbctx_t *context, rbspan_t *span)
+{
+    return ringbuffer_read_peek_timed(context, span, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_read_peek_timed(rbctx_t *context, rbspan_t *span, int64_t timeout_ns)
+{
+    // counted as a read once released
+    return stats_read(context, ring_peek(context, SIZE_MAX, span, timeout_ns), 0, 0);
+}
+
+void ringbuffer_read_release(rbctx_t *context, rbspan_t *span)
+{
+    stats_read(context, SUCCESS, 1, span->len[0] + span->len[1]);
+    if (context->mode == RB_MODE_MPMC) {
+        mpmc_release(context, (rbslot_t *)span->frame, span->pos);
+    } else if (spsc_cursors(context)) {
+        hist_read(context);
+        atomic_store_explicit(&context->head, span->pos, memory_order_release);
+        event_notify(context, &context->space_event, context->space_cond, 0);
+        if (context->mode == RB_MODE_TWOLOCK) {
+            pthread_mutex_unlock(&context->read_mtx);
+        }
+    } else {
+        hist_read(context);
+        context->read = span->frame;
+        context->read_seq++;
+        event_notify(context, &context->space_event, context->space_cond, 0); // signal to writer
+        locked_unlock(context);
+    }
+}
+
+int ringbuffer_read_cancel(rbctx_t *context, rbspan_t *span)
+{
+    (void) span;
+    if (context->mode == RB_MODE_MPMC) {
+        return ENOTSUP; // the slot is already claimed
+    }
+    if (context->mode == RB_MODE_LOCKED) {
+        locked_unlock(context);
+    } else if (context->mode == RB_MODE_TWOLOCK) {
+        pthread_mutex_unlock(&context->read_mtx);
+    }
+    return SUCCESS;
+}
+
+// -------------------- SCATTER-GATHER -------------------- //
+
+int ringbuffer_writev(rbctx_t *context, const struct iovec *iov, int iovcnt)
+{
+    return ringbuffer_writev_timed(context, iov, iovcnt, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_writev_timed(rbctx_t *context, const struct iovec *iov, int iovcnt, int64_t timeout_ns)
+{
+    size_t message_len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        message_len += iov[i].iov_len;
+    }
+
+    // reserve/commit is one critical section in the locked ring
+    rbspan_t span;
+    if (ringbuffer_write_reserve_timed(context, message_len, &span, timeout_ns) != SUCCESS) {
+        return RINGBUFFER_FULL;
+    }
+    size_t offset = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        offset += ringbuffer_span_write(&span, offset, iov[i].iov_base, iov[i].iov_len);
+    }
+    return ringbuffer_write_commit(context, &span, message_len);
+}
+
+int ringbuffer_readv(rbctx_t *context, const struct iovec *iov, int iovcnt, size_t *message_len)
+{
+    return ringbuffer_readv_timed(context, iov, iovcnt, message_len, RB_TIMEOUT_DEFAULT);
+}
+
+int ringbuffer_readv_timed(rbctx_t *context, const struct iovec *iov, int iovcnt, size_t *message_len,
+                           int64_t timeout_ns)
+{
+    size_t capacity = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        capacity += iov[i].iov_len;
+    }
+    *message_len = 0;
+    if (capacity == 0) {
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+
+    rbspan_t span;
+    int res = ring_peek(context, capacity, &span, timeout_ns);
+    if (res != SUCCESS) {
+        return stats_read(context, res, 0, 0);
+    }
+    size_t len = span.len[0] + span.len[1];
+    size_t offset = 0;
+    for (int i = 0; i < iovcnt && offset < len; i++) {
+        offset += ringbuffer_span_read(&span, offset, iov[i].iov_base, iov[i].iov_len);
+    }
+    ringbuffer_read_release(context, &span);
+    *message_len = len;
+    return SUCCESS;
+}
+
+size_t ringbuffer_span_write(const rbspan_t *span, size_t offset, const void *src, size_t len)
+{
+    size_t copied = 0;
+    for (int i = 0; i < 2 && copied < len; i++) {
+        if (offset >= span->len[i]) {
+            offset -= span->len[i];
+            continue;
+        }
+        size_t n = span->len[i] - offset;
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        memcpy(span->ptr[i] + offset, (const uint8_t *)src + copied, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+size_t ringbuffer_span_read(const rbspan_t *span, size_t offset, void *dst, size_t len)
+{
+    size_t copied = 0;
+    for (int i = 0; i < 2 && copied < len; i++) {
+        if (offset >= span->len[i]) {
+            offset -= span->len[i];
+            continue;
+        }
+        size_t n = span->len[i] - offset;
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        memcpy((uint8_t *)dst + copied, span->ptr[i] + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+void ringbuffer_destroy(rbctx_t *context)
+{
+    /* your solution here */
+    if (context->storage == RB_STORAGE_MIRRORED && context->begin != NULL) {
+        munmap(context->begin, 2 * (size_t)(context->end - context->begin));
+    }
+    if (context->storage == RB_STORAGE_HEAP) {
+        free(context->begin);
+    }
+    if (context->storage == RB_STORAGE_MAPPED && context->begin != NULL) {
+        munmap(context->begin, context->map_size); // also unlocks it
+    }
+    if (context->storage == RB_STORAGE_SHARED && context->shared != NULL) {
+        // the shared mutex and condition variables stay, other processes may still use them
+        munmap(context->shared, context->shared->map_size);
+    }
+    context->shared = NULL;
+    context->lock = &context->mtx;
+    context->data_cond = &context->sig;
+    context->space_cond = &context->space;
+    context->storage = RB_STORAGE_USER;
+    rbevent_t *events[] = {&context->data_event, &context->space_event};
+    for (int i = 0; i < 2; i++) {
+        if (events[i]->fd >= 0) {
+            close(events[i]->fd);
+            events[i]->fd = -1;
+        }
+    }
     context->begin = NULL;
     context->end = NULL;    
     context->read = NULL;    
     context->write = NULL;
     // destroy mutex and signal
     pthread_mutex_destroy(&context->mtx);
+    pthread_mutex_destroy(&context->read_mtx);
+    pthread_mutex_destroy(&context->write_mtx);
     pthread_cond_destroy(&context->sig);
+    pthread_cond_destroy(&context->space);
 }
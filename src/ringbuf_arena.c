@@ -0,0 +1,206 @@
+#include "../include/ringbuf_arena.h"
+#include "ringbuf_wait.h"
+
+#define RB_LARGE_INLINE 0 // the message follows the tag
+#define RB_LARGE_OOB 1    // a descriptor follows the tag
+
+// what the ring carries for an out-of-band message
+typedef struct {
+    uint32_t block;
+    uint32_t reserved;
+    uint64_t len;
+} rblarge_desc_t;
+
+int ringbuffer_arena_init(rbarena_t *arena, void *memory, size_t memory_size, size_t block_size, size_t threshold)
+{
+    block_size = (block_size + RB_CACHE_LINE - 1) & ~(size_t)(RB_CACHE_LINE - 1);
+    if (block_size == 0 || threshold >= block_size) {
+        return EINVAL;
+    }
+    // the links first, then the blocks from the next cache line on
+    size_t count = memory_size / (block_size + sizeof(uint32_t));
+    uintptr_t start = (uintptr_t) memory;
+    uintptr_t blocks;
+    for (;; count--) {
+        if (count == 0) {
+            return EINVAL;
+        }
+        blocks = (start + count * sizeof(uint32_t) + RB_CACHE_LINE - 1) & ~(uintptr_t)(RB_CACHE_LINE - 1);
+        if (blocks + count * block_size <= start + memory_size) {
+            break;
+        }
+    }
+    if (count >= RB_ARENA_NO_BLOCK) {
+        count = RB_ARENA_NO_BLOCK - 1;
+    }
+
+    arena->next = memory;
+    arena->blocks = (uint8_t *) blocks;
+    arena->block_size = block_size;
+    arena->block_count = count;
+    arena->threshold = threshold;
+    for (uint32_t i = 0; i < count; i++) {
+        atomic_init(&arena->next[i], i + 1 < count ? i + 1 : RB_ARENA_NO_BLOCK);
+    }
+    atomic_init(&arena->free_head, 0); // generation 0, block 0
+    atomic_init(&arena->free_blocks, count);
+    atomic_init(&arena->large_messages, 0);
+    atomic_init(&arena->exhausted, 0);
+    arena->wait = RB_WAIT_CONDVAR;
+    event_init(&arena->free_event);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&arena->mtx, NULL);
+    pthread_cond_init(&arena->freed, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    return SUCCESS;
+}
+
+size_t ringbuffer_arena_free_blocks(rbarena_t *arena)
+{
+    return atomic_load(&arena->free_blocks);
+}
+
+static uint32_t arena_pop(rbarena_t *arena)
+{
+    uint64_t head = atomic_load_explicit(&arena->free_head, memory_order_acquire);
+    for (;;) {
+        uint32_t block = (uint32_t) head;
+        if (block == RB_ARENA_NO_BLOCK) {
+            return RB_ARENA_NO_BLOCK;
+        }
+        uint32_t next = atomic_load_explicit(&arena->next[block], memory_order_relaxed);
+        uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+        if (atomic_compare_exchange_weak_explicit(&arena->free_head, &head, new_head,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            atomic_fetch_sub_explicit(&arena->free_blocks, 1, memory_order_relaxed);
+            return block;
+        }
+    }
+}
+
+static void arena_push(rbarena_t *arena, uint32_t block)
+{
+    uint64_t head = atomic_load_explicit(&arena->free_head, memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        atomic_store_explicit(&arena->next[block], (uint32_t) head, memory_order_relaxed);
+        new_head = ((head >> 32) + 1) << 32 | block;
+    } while (!atomic_compare_exchange_weak_explicit(&arena->free_head, &head, new_head,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_fetch_add_explicit(&arena->free_blocks, 1, memory_order_relaxed);
+
+    event_wake(&arena->free_event, arena->wait, &arena->mtx, &arena->freed, 1);
+}
+
+static uint32_t arena_alloc(rbarena_t *arena, rbdeadline_t *deadline)
+{
+    uint32_t block = arena_pop(arena);
+    if (block != RB_ARENA_NO_BLOCK) {
+        return block;
+    }
+    atomic_fetch_add_explicit(&arena->exhausted, 1, memory_order_relaxed);
+    for (;;) {
+        uint32_t seen = event_seq(&arena->free_event);
+        block = arena_pop(arena);
+        if (block != RB_ARENA_NO_BLOCK) {
+            return block;
+        }
+        if (wait_step(&arena->free_event, arena->wait, &arena->mtx, &arena->freed, seen, deadline) == ETIMEDOUT) {
+            return RB_ARENA_NO_BLOCK;
+        }
+    }
+}
+
+static int large_supported(const rbctx_t *context)
+{
+    return context->mode != RB_MODE_MPMC && context->framing != RB_FRAME_FIXED;
+}
+
+int ringbuffer_write_large(rbctx_t *context, rbarena_t *arena, const void *message, size_t message_len, int64_t timeout_ns)
+{
+    if (!large_supported(context)) {
+        return ENOTSUP;
+    }
+    uint8_t tag = RB_LARGE_INLINE;
+    rbspan_t span;
+    if (message_len <= arena->threshold) {
+        int res = ringbuffer_write_reserve_timed(context, 1 + message_len, &span, timeout_ns);
+        if (res != SUCCESS) {
+            return res;
+        }
+        ringbuffer_span_write(&span, 0, &tag, 1);
+        ringbuffer_span_write(&span, 1, message, message_len);
+        return ringbuffer_write_commit(context, &span, 1 + message_len);
+    }
+    if (message_len > arena->block_size) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+
+    // the ring reservation below gets what is left of the timeout
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+    deadline_start(&deadline);
+    rblarge_desc_t desc = {.block = arena_alloc(arena, &deadline), .reserved = 0, .len = message_len};
+    if (desc.block == RB_ARENA_NO_BLOCK) {
+        return RINGBUFFER_FULL;
+    }
+    // the block is filled before the descriptor is published
+    memcpy(arena->blocks + (size_t) desc.block * arena->block_size, message, message_len);
+    int res = ringbuffer_write_reserve_timed(context, 1 + sizeof(desc), &span, deadline_remaining(&deadline));
+    if (res != SUCCESS) {
+        arena_push(arena, desc.block);
+        return res;
+    }
+    tag = RB_LARGE_OOB;
+    ringbuffer_span_write(&span, 0, &tag, 1);
+    ringbuffer_span_write(&span, 1, &desc, sizeof(desc));
+    atomic_fetch_add_explicit(&arena->large_messages, 1, memory_order_relaxed);
+    return ringbuffer_write_commit(context, &span, 1 + sizeof(desc));
+}
+
+int ringbuffer_read_large(rbctx_t *context, rbarena_t *arena, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns)
+{
+    if (!large_supported(context)) {
+        return ENOTSUP;
+    }
+    rbspan_t span;
+    int res = ringbuffer_read_peek_timed(context, &span, timeout_ns);
+    if (res != SUCCESS) {
+        return res;
+    }
+    uint8_t tag;
+    ringbuffer_span_read(&span, 0, &tag, 1);
+    if (tag == RB_LARGE_INLINE) {
+        size_t message_len = span.len[0] + span.len[1] - 1;
+        if (message_len > *buffer_len_ptr) {
+            ringbuffer_read_cancel(context, &span);
+            return OUTPUT_BUFFER_TOO_SMALL;
+        }
+        ringbuffer_span_read(&span, 1, buffer, message_len);
+        ringbuffer_read_release(context, &span);
+        *buffer_len_ptr = message_len;
+        return SUCCESS;
+    }
+
+    rblarge_desc_t desc;
+    ringbuffer_span_read(&span, 1, &desc, sizeof(desc));
+    if (desc.len > *buffer_len_ptr) {
+        ringbuffer_read_cancel(context, &span);
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+    // the ring space goes back first, the block is only ours once the descriptor is consumed
+    ringbuffer_read_release(context, &span);
+    memcpy(buffer, arena->blocks + (size_t) desc.block * arena->block_size, desc.len);
+    arena_push(arena, desc.block);
+    *buffer_len_ptr = desc.len;
+    return SUCCESS;
+}
+
+void ringbuffer_arena_destroy(rbarena_t *arena)
+{
+    pthread_mutex_destroy(&arena->mtx);
+    pthread_cond_destroy(&arena->freed);
+}
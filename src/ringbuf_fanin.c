@@ -0,0 +1,221 @@
+#include "../include/ringbuf_fanin.h"
+#include "ringbuf_wait.h"
+
+int ringbuffer_fanin_init(rbfanin_t *fanin, void *buffer_location, size_t buffer_size, size_t producers,
+                          const rbattr_t *attr)
+{
+    if (producers == 0 || producers > RB_FANIN_MAX_PRODUCERS) {
+        return EINVAL;
+    }
+    // the rings start on a cache line and are a power of two each, so all of them stay aligned
+    uintptr_t start = ((uintptr_t) buffer_location + RB_CACHE_LINE - 1) & ~(uintptr_t)(RB_CACHE_LINE - 1);
+    size_t usable = buffer_size - (start - (uintptr_t) buffer_location);
+    if (start - (uintptr_t) buffer_location > buffer_size || usable / producers < RB_CACHE_LINE) {
+        return EINVAL;
+    }
+    size_t ring_size = RB_CACHE_LINE;
+    while (ring_size * 2 <= usable / producers) {
+        ring_size *= 2;
+    }
+
+    if (attr != NULL) {
+        fanin->attr = *attr;
+    } else {
+        ringbuffer_attr_init(&fanin->attr);
+    }
+    fanin->attr.mode = RB_MODE_SPSC;
+    fanin->begin = (uint8_t *) start;
+    fanin->ring_size = ring_size;
+    fanin->producers = producers;
+    for (size_t i = 0; i < RB_FANIN_MAX_PRODUCERS; i++) {
+        atomic_init(&fanin->slot[i].reading, 0);
+        atomic_init(&fanin->slot[i].state, RB_FANIN_FREE);
+    }
+    fanin->wait = (fanin->attr.wait == RB_WAIT_DEFAULT) ? RB_WAIT_CONDVAR : fanin->attr.wait;
+    atomic_init(&fanin->ready, 0);
+    event_init(&fanin->ready_event);
+    atomic_init(&fanin->next, 0);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&fanin->reg_mtx, NULL);
+    pthread_mutex_init(&fanin->mtx, NULL);
+    pthread_cond_init(&fanin->sig, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    return SUCCESS;
+}
+
+int ringbuffer_fanin_register(rbfanin_t *fanin, unsigned *producer)
+{
+    int res = EAGAIN;
+    pthread_mutex_lock(&fanin->reg_mtx);
+    for (unsigned i = 0; i < fanin->producers; i++) {
+        if (atomic_load(&fanin->slot[i].state) == RB_FANIN_FREE) {
+            ringbuffer_init_attr(&fanin->ring[i], fanin->begin + i * fanin->ring_size, fanin->ring_size, &fanin->attr);
+            // consumers only touch a ring after they saw it open
+            atomic_store_explicit(&fanin->slot[i].state, RB_FANIN_OPEN, memory_order_release);
+            *producer = i;
+            res = SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&fanin->reg_mtx);
+    return res;
+}
+
+/*
+ * Marks ring i as ready. The consumers only need a wakeup when the mask changes, they
+ * scan every ready ring before they sleep.
+ */
+static void fanin_mark_ready(rbfanin_t *fanin, unsigned i)
+{
+    uint64_t bit = UINT64_C(1) << i;
+    if (atomic_fetch_or(&fanin->ready, bit) & bit) {
+        return;
+    }
+    event_wake(&fanin->ready_event, fanin->wait, &fanin->mtx, &fanin->sig, 1);
+}
+
+void ringbuffer_fanin_deregister(rbfanin_t *fanin, unsigned producer)
+{
+    if (producer >= fanin->producers) {
+        return;
+    }
+    // everything written before is drained before the ring is freed
+    atomic_store_explicit(&fanin->slot[producer].state, RB_FANIN_CLOSED, memory_order_release);
+    fanin_mark_ready(fanin, producer);
+}
+
+int ringbuffer_fanin_write(rbfanin_t *fanin, unsigned producer, void *message, size_t message_len, int64_t timeout_ns)
+{
+    if (producer >= fanin->producers ||
+        atomic_load_explicit(&fanin->slot[producer].state, memory_order_relaxed) != RB_FANIN_OPEN) {
+        return EINVAL;
+    }
+    int res = ringbuffer_write_timed(&fanin->ring[producer], message, message_len, timeout_ns);
+    if (res != SUCCESS) {
+        return res;
+    }
+    // pairs with the fence in fanin_try_ring: either we see the bit cleared, or the consumer sees our message
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!(atomic_load_explicit(&fanin->ready, memory_order_relaxed) & (UINT64_C(1) << producer))) {
+        fanin_mark_ready(fanin, producer);
+    }
+    return SUCCESS;
+}
+
+/*
+ * Frees a closed and drained ring, with its claim held.
+ */
+static void fanin_free(rbfanin_t *fanin, unsigned i)
+{
+    pthread_mutex_lock(&fanin->reg_mtx);
+    ringbuffer_destroy(&fanin->ring[i]);
+    atomic_store(&fanin->slot[i].reading, 0);
+    atomic_store(&fanin->slot[i].state, RB_FANIN_FREE);
+    pthread_mutex_unlock(&fanin->reg_mtx);
+}
+
+/*
+ * Reads one message from ring i unless another consumer has the ring. A ring found empty
+ * leaves the ready mask, a closed one is freed once it is empty.
+ */
+static int fanin_try_ring(rbfanin_t *fanin, unsigned i, void *buffer, size_t *buffer_len, unsigned *producer)
+{
+    rbfanin_slot_t *slot = &fanin->slot[i];
+    if (atomic_load_explicit(&slot->reading, memory_order_relaxed) ||
+        atomic_exchange_explicit(&slot->reading, 1, memory_order_acquire)) {
+        return RINGBUFFER_EMPTY;
+    }
+    int state = atomic_load_explicit(&slot->state, memory_order_acquire);
+    if (state == RB_FANIN_FREE) {
+        atomic_store_explicit(&slot->reading, 0, memory_order_release);
+        return RINGBUFFER_EMPTY; // a stale bit from an older scan
+    }
+
+    size_t len = *buffer_len;
+    int res = ringbuffer_read_timed(&fanin->ring[i], buffer, buffer_len, RB_TIMEOUT_TRY);
+    if (res == RINGBUFFER_EMPTY) {
+        atomic_fetch_and(&fanin->ready, ~(UINT64_C(1) << i));
+        atomic_thread_fence(memory_order_seq_cst);
+        // a producer that still saw the bit did not set it again, so look once more
+        *buffer_len = len;
+        res = ringbuffer_read_timed(&fanin->ring[i], buffer, buffer_len, RB_TIMEOUT_TRY);
+        if (res != RINGBUFFER_EMPTY) {
+            fanin_mark_ready(fanin, i); // there may be more
+        } else if (state == RB_FANIN_CLOSED) {
+            fanin_free(fanin, i); // the producer wrote nothing after it closed
+            return RINGBUFFER_EMPTY;
+        }
+    }
+    if (res == SUCCESS && producer != NULL) {
+        *producer = i;
+    }
+    atomic_store_explicit(&slot->reading, 0, memory_order_release);
+
+    // a consumer that skipped the ring while we had it took its seq before and may be
+    // about to sleep, the bit is still set so nobody else will notify it
+    if (res != RINGBUFFER_EMPTY && (atomic_load(&fanin->ready) & (UINT64_C(1) << i))) {
+        event_wake(&fanin->ready_event, fanin->wait, &fanin->mtx, &fanin->sig, 1);
+    }
+    return res;
+}
+
+/*
+ * One scan over the ready rings, starting behind the ring the previous scan read from.
+ */
+static int fanin_try(rbfanin_t *fanin, void *buffer, size_t *buffer_len, unsigned *producer)
+{
+    uint64_t ready = atomic_load(&fanin->ready);
+    unsigned start = atomic_load_explicit(&fanin->next, memory_order_relaxed);
+    uint64_t behind = ready & (~UINT64_C(0) << start);
+    uint64_t rounds[2] = {behind, ready & ~behind};
+    size_t len = *buffer_len;
+
+    for (int round = 0; round < 2; round++) {
+        while (rounds[round] != 0) {
+            unsigned i = (unsigned) __builtin_ctzll(rounds[round]);
+            rounds[round] &= rounds[round] - 1;
+            *buffer_len = len;
+            int res = fanin_try_ring(fanin, i, buffer, buffer_len, producer);
+            if (res != RINGBUFFER_EMPTY) {
+                atomic_store_explicit(&fanin->next, (i + 1) % RB_FANIN_MAX_PRODUCERS, memory_order_relaxed);
+                return res;
+            }
+        }
+    }
+    *buffer_len = len;
+    return RINGBUFFER_EMPTY;
+}
+
+int ringbuffer_fanin_read(rbfanin_t *fanin, void *buffer, size_t *buffer_len, int64_t timeout_ns, unsigned *producer)
+{
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    for (;;) {
+        uint32_t seen = event_seq(&fanin->ready_event);
+        int res = fanin_try(fanin, buffer, buffer_len, producer);
+        if (res != RINGBUFFER_EMPTY) {
+            return res;
+        }
+        if (wait_step(&fanin->ready_event, fanin->wait, &fanin->mtx, &fanin->sig, seen, &deadline) == ETIMEDOUT) {
+            return RINGBUFFER_EMPTY;
+        }
+    }
+}
+
+void ringbuffer_fanin_destroy(rbfanin_t *fanin)
+{
+    for (size_t i = 0; i < fanin->producers; i++) {
+        if (atomic_load(&fanin->slot[i].state) != RB_FANIN_FREE) {
+            ringbuffer_destroy(&fanin->ring[i]);
+            atomic_store(&fanin->slot[i].state, RB_FANIN_FREE);
+        }
+    }
+    fanin->producers = 0;
+    pthread_mutex_destroy(&fanin->reg_mtx);
+    pthread_mutex_destroy(&fanin->mtx);
+    pthread_cond_destroy(&fanin->sig);
+}
@@ -0,0 +1,187 @@
+#include "../include/ringbuf_mcast.h"
+#include "ringbuf_wait.h"
+
+int ringbuffer_mcast_init(rbmcast_t *mc, void *buffer_location, size_t buffer_size)
+{
+    if (buffer_size <= sizeof(size_t)) {
+        return EINVAL;
+    }
+    // the largest power of two that fits, offsets are then cursor & mask
+    size_t capacity = 1;
+    while (capacity * 2 <= buffer_size) {
+        capacity *= 2;
+    }
+    mc->begin = buffer_location;
+    mc->mask = capacity - 1;
+    mc->gate_cache = 0;
+    atomic_init(&mc->tail, 0);
+    mc->wait = RB_WAIT_CONDVAR;
+    event_init(&mc->data_event);
+    event_init(&mc->space_event);
+    for (size_t i = 0; i < RB_MCAST_MAX_CONSUMERS; i++) {
+        atomic_init(&mc->consumers[i].head, 0);
+        atomic_init(&mc->consumers[i].active, 0);
+    }
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&mc->write_mtx, NULL);
+    pthread_mutex_init(&mc->mtx, NULL);
+    pthread_cond_init(&mc->data, &cond_attr);
+    pthread_cond_init(&mc->space, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    return SUCCESS;
+}
+
+int ringbuffer_mcast_subscribe(rbmcast_t *mc, unsigned *consumer)
+{
+    int res = EAGAIN;
+    // with write_mtx held tail stands still, writers see the new cursor on their next gate check
+    pthread_mutex_lock(&mc->write_mtx);
+    for (unsigned i = 0; i < RB_MCAST_MAX_CONSUMERS; i++) {
+        if (!atomic_load(&mc->consumers[i].active)) {
+            atomic_store(&mc->consumers[i].head, atomic_load(&mc->tail));
+            atomic_store(&mc->consumers[i].active, 1);
+            *consumer = i;
+            res = SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mc->write_mtx);
+    return res;
+}
+
+void ringbuffer_mcast_unsubscribe(rbmcast_t *mc, unsigned consumer)
+{
+    if (consumer >= RB_MCAST_MAX_CONSUMERS) {
+        return;
+    }
+    pthread_mutex_lock(&mc->write_mtx);
+    atomic_store(&mc->consumers[consumer].active, 0);
+    pthread_mutex_unlock(&mc->write_mtx);
+    // writers held back by this consumer may go on
+    event_wake(&mc->space_event, mc->wait, &mc->mtx, &mc->space, 1);
+}
+
+/*
+ * The slowest cursor of all consumers, tail without consumers. Called with write_mtx held.
+ */
+static size_t mcast_gate(rbmcast_t *mc, size_t tail)
+{
+    size_t gate = tail;
+    for (size_t i = 0; i < RB_MCAST_MAX_CONSUMERS; i++) {
+        if (atomic_load_explicit(&mc->consumers[i].active, memory_order_acquire)) {
+            size_t head = atomic_load_explicit(&mc->consumers[i].head, memory_order_acquire);
+            if (tail - head > tail - gate) {
+                gate = head;
+            }
+        }
+    }
+    return gate;
+}
+
+static void mcast_put(rbmcast_t *mc, size_t cursor, const void *src, size_t len)
+{
+    size_t offset = cursor & mc->mask;
+    size_t first = mc->mask + 1 - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(mc->begin + offset, src, first);
+    memcpy(mc->begin, (const uint8_t *)src + first, len - first);
+}
+
+static void mcast_get(rbmcast_t *mc, size_t cursor, void *dst, size_t len)
+{
+    size_t offset = cursor & mc->mask;
+    size_t first = mc->mask + 1 - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, mc->begin + offset, first);
+    memcpy((uint8_t *)dst + first, mc->begin, len - first);
+}
+
+int ringbuffer_mcast_write(rbmcast_t *mc, const void *message, size_t message_len, int64_t timeout_ns)
+{
+    size_t capacity = mc->mask + 1;
+    size_t frame = sizeof(size_t) + message_len;
+    if (message_len > capacity - sizeof(size_t)) {
+        return RINGBUFFER_FULL; // can never fit
+    }
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    for (;;) {
+        uint32_t seen = event_seq(&mc->space_event);
+        pthread_mutex_lock(&mc->write_mtx);
+        size_t tail = atomic_load_explicit(&mc->tail, memory_order_relaxed);
+        if (tail + frame - mc->gate_cache > capacity) {
+            mc->gate_cache = mcast_gate(mc, tail);
+        }
+        if (tail + frame - mc->gate_cache <= capacity) {
+            mcast_put(mc, tail, &message_len, sizeof(size_t));
+            mcast_put(mc, tail + sizeof(size_t), message, message_len);
+            atomic_store_explicit(&mc->tail, tail + frame, memory_order_release);
+            pthread_mutex_unlock(&mc->write_mtx);
+            event_wake(&mc->data_event, mc->wait, &mc->mtx, &mc->data, 1);
+            return SUCCESS;
+        }
+        pthread_mutex_unlock(&mc->write_mtx);
+
+        // wait outside write_mtx, subscribe and unsubscribe must not wait for a slow consumer
+        if (wait_step(&mc->space_event, mc->wait, &mc->mtx, &mc->space, seen, &deadline) == ETIMEDOUT) {
+            return RINGBUFFER_FULL;
+        }
+    }
+}
+
+int ringbuffer_mcast_read(rbmcast_t *mc, unsigned consumer, void *buffer, size_t *buffer_len_ptr, int64_t timeout_ns)
+{
+    if (consumer >= RB_MCAST_MAX_CONSUMERS || !atomic_load(&mc->consumers[consumer].active)) {
+        return EINVAL;
+    }
+    rbmcast_consumer_t *self = &mc->consumers[consumer];
+    size_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    for (;;) {
+        uint32_t seen = event_seq(&mc->data_event);
+        if (atomic_load_explicit(&mc->tail, memory_order_acquire) != head) {
+            break;
+        }
+        if (wait_step(&mc->data_event, mc->wait, &mc->mtx, &mc->data, seen, &deadline) == ETIMEDOUT) {
+            return RINGBUFFER_EMPTY;
+        }
+    }
+
+    size_t message_len;
+    mcast_get(mc, head, &message_len, sizeof(size_t));
+    if (message_len > *buffer_len_ptr) {
+        return OUTPUT_BUFFER_TOO_SMALL;
+    }
+    mcast_get(mc, head + sizeof(size_t), buffer, message_len);
+    *buffer_len_ptr = message_len;
+    // the frame is copied out before writers may reuse it
+    atomic_store_explicit(&self->head, head + sizeof(size_t) + message_len, memory_order_release);
+    event_wake(&mc->space_event, mc->wait, &mc->mtx, &mc->space, 1);
+    return SUCCESS;
+}
+
+size_t ringbuffer_mcast_lag(rbmcast_t *mc, unsigned consumer)
+{
+    if (consumer >= RB_MCAST_MAX_CONSUMERS || !atomic_load(&mc->consumers[consumer].active)) {
+        return 0;
+    }
+    return atomic_load(&mc->tail) - atomic_load(&mc->consumers[consumer].head);
+}
+
+void ringbuffer_mcast_destroy(rbmcast_t *mc)
+{
+    pthread_mutex_destroy(&mc->write_mtx);
+    pthread_mutex_destroy(&mc->mtx);
+    pthread_cond_destroy(&mc->data);
+    pthread_cond_destroy(&mc->space);
+}
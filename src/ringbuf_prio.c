@@ -0,0 +1,152 @@
+#include "../include/ringbuf_prio.h"
+#include "ringbuf_wait.h"
+
+void ringbuffer_prio_attr_init(rbprio_attr_t *attr)
+{
+    attr->lanes = 4;
+    attr->policy = RB_PRIO_STRICT;
+    for (size_t i = 0; i < RB_PRIO_MAX_LANES; i++) {
+        attr->weights[i] = (i < 4) ? 8u >> i : 1; // 8, 4, 2, 1, then 1
+    }
+    ringbuffer_attr_init(&attr->ring);
+}
+
+int ringbuffer_prio_init(rbprio_t *prio, void *buffer_location, size_t buffer_size, const rbprio_attr_t *attr)
+{
+    rbprio_attr_t defaults;
+    if (attr == NULL) {
+        ringbuffer_prio_attr_init(&defaults);
+        attr = &defaults;
+    }
+    if (attr->lanes == 0 || attr->lanes > RB_PRIO_MAX_LANES) {
+        return EINVAL;
+    }
+    for (size_t i = 0; i < attr->lanes; i++) {
+        if (attr->weights[i] == 0) {
+            return EINVAL;
+        }
+    }
+
+    // equal lanes, each starting on its own cache line
+    size_t lane_size = (buffer_size / attr->lanes) & ~(size_t)(RB_CACHE_LINE - 1);
+    for (size_t i = 0; i < attr->lanes; i++) {
+        ringbuffer_init_attr(&prio->lane[i], (uint8_t *)buffer_location + i * lane_size, lane_size, &attr->ring);
+        prio->weights[i] = attr->weights[i];
+    }
+    prio->lanes = attr->lanes;
+    prio->policy = attr->policy;
+    prio->current = 0;
+    prio->credit = prio->weights[0];
+    prio->wait = (attr->ring.wait == RB_WAIT_DEFAULT) ? RB_WAIT_CONDVAR : attr->ring.wait;
+    event_init(&prio->data_event);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&prio->mtx, NULL);
+    pthread_cond_init(&prio->sig, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    return SUCCESS;
+}
+
+int ringbuffer_prio_write(rbprio_t *prio, unsigned priority, void *message, size_t message_len, int64_t timeout_ns)
+{
+    if (priority >= prio->lanes) {
+        return EINVAL;
+    }
+    int res = ringbuffer_write_timed(&prio->lane[priority], message, message_len, timeout_ns);
+    if (res != SUCCESS) {
+        return res;
+    }
+    event_wake(&prio->data_event, prio->wait, &prio->mtx, &prio->sig, 1);
+    return SUCCESS;
+}
+
+static int prio_try_lane(rbprio_t *prio, size_t lane, void *buffer, size_t *buffer_len, unsigned *priority)
+{
+    int res = ringbuffer_read_timed(&prio->lane[lane], buffer, buffer_len, RB_TIMEOUT_TRY);
+    if (res == SUCCESS && priority != NULL) {
+        *priority = lane;
+    }
+    return res;
+}
+
+static int prio_try_strict(rbprio_t *prio, void *buffer, size_t *buffer_len, unsigned *priority)
+{
+    size_t len = *buffer_len;
+    for (size_t lane = 0; lane < prio->lanes; lane++) {
+        *buffer_len = len;
+        int res = prio_try_lane(prio, lane, buffer, buffer_len, priority);
+        if (res != RINGBUFFER_EMPTY) {
+            return res;
+        }
+    }
+    return RINGBUFFER_EMPTY;
+}
+
+/*
+ * The current lane delivers until its credit is used up or it runs empty, then the
+ * turn passes to the next lane with a fresh credit of its weight.
+ */
+static int prio_try_weighted(rbprio_t *prio, void *buffer, size_t *buffer_len, unsigned *priority)
+{
+    size_t len = *buffer_len;
+    int res = RINGBUFFER_EMPTY;
+    pthread_mutex_lock(&prio->mtx);
+    for (size_t tried = 0; tried < prio->lanes; tried++) {
+        if (prio->credit == 0) {
+            prio->current = (prio->current + 1) % prio->lanes;
+            prio->credit = prio->weights[prio->current];
+        }
+        *buffer_len = len;
+        res = prio_try_lane(prio, prio->current, buffer, buffer_len, priority);
+        if (res == SUCCESS) {
+            prio->credit--;
+            break;
+        }
+        if (res != RINGBUFFER_EMPTY) {
+            break;
+        }
+        prio->credit = 0; // an empty lane gives up the rest of its turn
+    }
+    pthread_mutex_unlock(&prio->mtx);
+    return res;
+}
+
+int ringbuffer_prio_read(rbprio_t *prio, void *buffer, size_t *buffer_len, int64_t timeout_ns, unsigned *priority)
+{
+    rbdeadline_t deadline;
+    deadline_init(&deadline, timeout_ns);
+
+    for (;;) {
+        uint32_t seen = event_seq(&prio->data_event);
+        int res = (prio->policy == RB_PRIO_WEIGHTED) ? prio_try_weighted(prio, buffer, buffer_len, priority) :
+                                                        prio_try_strict(prio, buffer, buffer_len, priority);
+        if (res != RINGBUFFER_EMPTY) {
+            return res;
+        }
+        if (wait_step(&prio->data_event, prio->wait, &prio->mtx, &prio->sig, seen, &deadline) == ETIMEDOUT) {
+            return RINGBUFFER_EMPTY;
+        }
+    }
+}
+
+void ringbuffer_prio_get_stats(rbprio_t *prio, rbprio_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < prio->lanes; i++) {
+        ringbuffer_get_stats(&prio->lane[i], &stats->lane[i]);
+        // from the lane's positions, the counters may have been reset or miss dropped messages
+        stats->queued_bytes[i] = ringbuffer_used(&prio->lane[i]);
+    }
+}
+
+void ringbuffer_prio_destroy(rbprio_t *prio)
+{
+    for (size_t i = 0; i < prio->lanes; i++) {
+        ringbuffer_destroy(&prio->lane[i]);
+    }
+    prio->lanes = 0;
+    pthread_mutex_destroy(&prio->mtx);
+    pthread_cond_destroy(&prio->sig);
+}
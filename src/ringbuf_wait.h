@@ -0,0 +1,210 @@
+#ifndef RINGBUF_WAIT_H
+#define RINGBUF_WAIT_H
+
+/*
+ * Waiting for an rbevent_t, shared by the ring and the structures built on top of it.
+ * Internal to the library, not installed with the public headers.
+ */
+
+#include "../include/ringbuf.h"
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#ifdef __linux__
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+/*
+ * A wait that ends at a CLOCK_MONOTONIC deadline. The clock is first read when the caller
+ * actually has to wait, so operations that succeed right away never pay for it. Every
+ * strategy polls for RB_SPIN_LIMIT rounds before it looks at the clock again.
+ */
+#define RB_SPIN_LIMIT 128
+
+typedef struct {
+    int64_t timeout_ns;  // RB_TIMEOUT_TRY, negative for RB_TIMEOUT_INFINITE
+    struct timespec at;  // absolute deadline of a finite timeout, set by deadline_start
+    struct timespec since; // when the caller started to wait
+    int started;
+    unsigned spins;
+} rbdeadline_t;
+
+static inline void deadline_init(rbdeadline_t *deadline, int64_t timeout_ns)
+{
+    deadline->timeout_ns = timeout_ns;
+    deadline->started = 0;
+    deadline->spins = 0;
+}
+
+static inline void deadline_start(rbdeadline_t *deadline)
+{
+    if (deadline->started || deadline->timeout_ns == RB_TIMEOUT_TRY) {
+        return;
+    }
+    deadline->started = 1;
+    clock_gettime(CLOCK_MONOTONIC, &deadline->since);
+    if (deadline->timeout_ns < 0) {
+        return;
+    }
+    deadline->at = deadline->since;
+    deadline->at.tv_sec += deadline->timeout_ns / 1000000000;
+    deadline->at.tv_nsec += deadline->timeout_ns % 1000000000;
+    if (deadline->at.tv_nsec >= 1000000000) {
+        deadline->at.tv_sec++;
+        deadline->at.tv_nsec -= 1000000000;
+    }
+}
+
+static inline int deadline_expired(const rbdeadline_t *deadline)
+{
+    if (deadline->timeout_ns < 0) {
+        return 0;
+    }
+    if (deadline->timeout_ns == RB_TIMEOUT_TRY) {
+        return 1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->at.tv_sec ||
+           (now.tv_sec == deadline->at.tv_sec && now.tv_nsec >= deadline->at.tv_nsec);
+}
+
+/*
+ * What is left of a started deadline, as a timeout for a wait that follows: RB_TIMEOUT_TRY
+ * once it passed, the timeout itself for RB_TIMEOUT_TRY and RB_TIMEOUT_INFINITE.
+ */
+static inline int64_t deadline_remaining(const rbdeadline_t *deadline)
+{
+    if (deadline->timeout_ns <= 0) {
+        return deadline->timeout_ns;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t left = (int64_t)(deadline->at.tv_sec - now.tv_sec) * 1000000000 + (deadline->at.tv_nsec - now.tv_nsec);
+    return left > 0 ? left : RB_TIMEOUT_TRY;
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/*
+ * An event without waiters and without an eventfd.
+ */
+static inline void event_init(rbevent_t *event)
+{
+    atomic_init(&event->seq, 0);
+    atomic_init(&event->waiters, 0);
+    event->fd = -1;
+    atomic_init(&event->armed, 0);
+}
+
+static inline uint32_t event_seq(rbevent_t *event)
+{
+    return atomic_load_explicit(&event->seq, memory_order_acquire);
+}
+
+/*
+ * Parks the caller until event->seq moves away from seen or the deadline passes.
+ * RB_WAIT_FUTEX parks on seq itself, the other strategies sleep on cond under lock.
+ * May return early, the caller checks its condition again either way.
+ */
+static inline void event_park(rbevent_t *event, rbwait_t wait, pthread_mutex_t *lock, pthread_cond_t *cond,
+                              uint32_t seen, const rbdeadline_t *deadline)
+{
+    atomic_fetch_add(&event->waiters, 1);
+#ifdef __linux__
+    if (wait == RB_WAIT_FUTEX) {
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline and returns at once if seq != seen
+        syscall(SYS_futex, (uint32_t *)&event->seq, FUTEX_WAIT_BITSET_PRIVATE, seen,
+                deadline->timeout_ns < 0 ? NULL : &deadline->at, NULL, FUTEX_BITSET_MATCH_ANY);
+        atomic_fetch_sub(&event->waiters, 1);
+        return;
+    }
+#else
+    (void)wait;
+#endif
+    pthread_mutex_lock(lock);
+    while (atomic_load(&event->seq) == seen) {
+        if (deadline->timeout_ns < 0) {
+            pthread_cond_wait(cond, lock);
+        } else if (pthread_cond_timedwait(cond, lock, &deadline->at) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(lock);
+    atomic_fetch_sub(&event->waiters, 1);
+}
+
+/*
+ * Bumps event->seq and wakes one (or all) of the threads parked on it, if there are any.
+ * Parked threads raise waiters before they check seq again, so either they see the new
+ * seq or we see them. lock is NULL when the caller holds it already. Sleepers on cond
+ * are always broadcast to, each of them may wait for a different seq.
+ */
+static inline void event_wake(rbevent_t *event, rbwait_t wait, pthread_mutex_t *lock, pthread_cond_t *cond, int all)
+{
+    atomic_fetch_add(&event->seq, 1);
+    if (atomic_load(&event->waiters) == 0) {
+        return; // nobody parked, skip the syscall
+    }
+#ifdef __linux__
+    if (wait == RB_WAIT_FUTEX) {
+        syscall(SYS_futex, (uint32_t *)&event->seq, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+        return;
+    }
+#else
+    (void)wait;
+    (void)all;
+#endif
+    if (lock != NULL) {
+        pthread_mutex_lock(lock);
+    }
+    pthread_cond_broadcast(cond);
+    if (lock != NULL) {
+        pthread_mutex_unlock(lock);
+    }
+}
+
+/*
+ * One round of waiting for event, seen being its seq from before the caller checked its
+ * condition. Returns ETIMEDOUT once the deadline has passed, SUCCESS when the caller
+ * should check again.
+ */
+static inline int wait_step(rbevent_t *event, rbwait_t wait, pthread_mutex_t *lock, pthread_cond_t *cond,
+                            uint32_t seen, rbdeadline_t *deadline)
+{
+    if (deadline->timeout_ns == RB_TIMEOUT_TRY) {
+        return ETIMEDOUT;
+    }
+    deadline_start(deadline);
+    if (++deadline->spins < RB_SPIN_LIMIT) {
+        return SUCCESS;
+    }
+    if (deadline_expired(deadline)) {
+        return ETIMEDOUT;
+    }
+    switch (wait) {
+    case RB_WAIT_SPIN:
+        deadline->spins = 0; // next clock check after another RB_SPIN_LIMIT rounds
+        cpu_relax();
+        break;
+    case RB_WAIT_SPIN_YIELD:
+        sched_yield();
+        break;
+    default:
+        event_park(event, wait, lock, cond, seen, deadline);
+        break;
+    }
+    return SUCCESS;
+}
+
+#endif //RINGBUF_WAIT_H
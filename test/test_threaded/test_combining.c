@@ -0,0 +1,181 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+
+#define NUMBER_OF_WRITERS 32
+#define MESSAGES_PER_WRITER 2000
+#define NUMBER_OF_MESSAGES (NUMBER_OF_WRITERS * MESSAGES_PER_WRITER)
+#define NUMBER_OF_READERS 2
+#define MAX_MESSAGE_SIZE 40  // bytes
+#define RBUF_SIZE 1024  // bytes
+
+/********************************************************************
+* Many writers on a combining RB_MODE_LOCKED ringbuffer, so that the
+* lock holder applies the writes of the others most of the time.
+* Every message has to arrive exactly once, each reader has to see
+* the messages of a writer in order, and a message that does not fit
+* has to come back to its writer.
+*********************************************************************/
+
+_Atomic int received[NUMBER_OF_MESSAGES];
+_Atomic int total_received = 0;
+
+typedef struct {
+    rbctx_t *rb;
+    int writer;
+} args_t;
+
+static size_t message_len(int idx)
+{
+    return sizeof(int) + idx % (MAX_MESSAGE_SIZE - sizeof(int) + 1);
+}
+
+void *writer(void *arg)
+{
+    args_t *args = arg;
+    unsigned char msg[MAX_MESSAGE_SIZE];
+
+    for (int i = args->writer * MESSAGES_PER_WRITER; i < (args->writer + 1) * MESSAGES_PER_WRITER; i++) {
+        size_t len = message_len(i);
+        memcpy(msg, &i, sizeof(int));
+        memset(msg + sizeof(int), 'a' + i % 26, len - sizeof(int));
+        if (ringbuffer_write_timed(args->rb, msg, len, RB_TIMEOUT_INFINITE) != SUCCESS) {
+            printf("Error: write failed\n");
+            exit(1);
+        }
+    }
+
+    return NULL;
+}
+
+void *reader(void *arg)
+{
+    rbctx_t *rb = arg;
+    unsigned char buf[MAX_MESSAGE_SIZE];
+    int last[NUMBER_OF_WRITERS];
+    for (int w = 0; w < NUMBER_OF_WRITERS; w++) {
+        last[w] = -1;
+    }
+
+    while (atomic_load(&total_received) < NUMBER_OF_MESSAGES) {
+        size_t len = sizeof(buf);
+        if (ringbuffer_read_timed(rb, buf, &len, 1000000) != SUCCESS) {
+            continue;
+        }
+        int idx;
+        memcpy(&idx, buf, sizeof(int));
+        if (idx < 0 || idx >= NUMBER_OF_MESSAGES || len != message_len(idx)) {
+            printf("Error: corrupted message\n");
+            exit(1);
+        }
+        for (size_t j = sizeof(int); j < len; j++) {
+            if (buf[j] != 'a' + idx % 26) {
+                printf("Error: corrupted payload of message %d\n", idx);
+                exit(1);
+            }
+        }
+        int w = idx / MESSAGES_PER_WRITER;
+        if (idx <= last[w]) {
+            printf("Error: message %d of writer %d read after message %d\n", idx, w, last[w]);
+            exit(1);
+        }
+        last[w] = idx;
+        atomic_fetch_add(&received[idx], 1);
+        atomic_fetch_add(&total_received, 1);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.combining = 1;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+    /* without contention a combining write is a plain write */
+    unsigned char msg[RBUF_SIZE];
+    memset(msg, 'x', sizeof(msg));
+    size_t len = sizeof(msg);
+    if (ringbuffer_write_timed(ringbuffer_context, msg, 100, RB_TIMEOUT_TRY) != SUCCESS ||
+        ringbuffer_read_timed(ringbuffer_context, msg, &len, RB_TIMEOUT_TRY) != SUCCESS || len != 100) {
+        printf("Error: single combining write failed\n");
+        exit(1);
+    }
+
+    /* a message that doesn't fit comes back to its writer, which doesn't wait with RB_TIMEOUT_TRY */
+    while (ringbuffer_write_timed(ringbuffer_context, msg, 100, RB_TIMEOUT_TRY) == SUCCESS);
+    if (ringbuffer_write_timed(ringbuffer_context, msg, 100, RB_TIMEOUT_TRY) != RINGBUFFER_FULL ||
+        ringbuffer_write_timed(ringbuffer_context, msg, sizeof(msg), RB_TIMEOUT_DEFAULT) != RINGBUFFER_FULL) {
+        printf("Error: expected RINGBUFFER_FULL\n");
+        exit(1);
+    }
+    do {
+        len = sizeof(msg);
+    } while (ringbuffer_read_timed(ringbuffer_context, msg, &len, RB_TIMEOUT_TRY) == SUCCESS);
+
+    /* the lock-free modes don't combine */
+    rbctx_t spsc;
+    attr.mode = RB_MODE_SPSC;
+    ringbuffer_init_attr(&spsc, msg, sizeof(msg), &attr);
+    if (spsc.combining) {
+        printf("Error: RB_MODE_SPSC ring combines\n");
+        exit(1);
+    }
+    ringbuffer_destroy(&spsc);
+
+    ringbuffer_reset_stats(ringbuffer_context);
+    printf("creating reader and writer threads\n");
+    pthread_t w_ids[NUMBER_OF_WRITERS], r_ids[NUMBER_OF_READERS];
+    args_t w_args[NUMBER_OF_WRITERS];
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_create(&r_ids[i], NULL, reader, ringbuffer_context);
+    }
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        w_args[i].rb = ringbuffer_context;
+        w_args[i].writer = i;
+        pthread_create(&w_ids[i], NULL, writer, &w_args[i]);
+    }
+
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        pthread_join(w_ids[i], NULL);
+    }
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_join(r_ids[i], NULL);
+    }
+
+    printf("comparing results\n");
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (received[i] != 1) {
+            printf("Error: message %d received %d times\n", i, received[i]);
+            exit(1);
+        }
+    }
+    rbstats_t stats;
+    ringbuffer_get_stats(ringbuffer_context, &stats);
+    if (atomic_load(&ringbuffer_context->combine_list) != NULL || stats.messages_written != NUMBER_OF_MESSAGES) {
+        printf("Error: unexpected state after the run\n");
+        exit(1);
+    }
+
+    ringbuffer_destroy(ringbuffer_context);
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("Test passed!\n");
+
+    return 0;
+}
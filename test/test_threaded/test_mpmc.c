@@ -0,0 +1,140 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+
+#define NUMBER_OF_MESSAGES 20000
+#define NUMBER_OF_WRITERS 4
+#define NUMBER_OF_READERS 4
+#define SLOT_SIZE 64  // bytes
+#define RBUF_SIZE 1024  // bytes
+
+/********************************************************************
+* Several writers and readers on a RB_MODE_MPMC ringbuffer. Every
+* message carries its own index, the readers count how often each
+* index was received. Every message has to arrive exactly once.
+*********************************************************************/
+
+_Atomic int received[NUMBER_OF_MESSAGES];
+_Atomic int total_received = 0;
+
+typedef struct {
+    rbctx_t *rb;
+    int from;
+    int to;
+} args_t;
+
+void *writer(void *arg)
+{
+    args_t *args = arg;
+    unsigned char msg[SLOT_SIZE];
+
+    for (int i = args->from; i < args->to; i++) {
+        memcpy(msg, &i, sizeof(int));
+        memset(msg + sizeof(int), 'a' + i % 26, SLOT_SIZE - sizeof(int));
+        size_t len = sizeof(int) + i % (SLOT_SIZE - sizeof(int) + 1);
+        while (ringbuffer_write(args->rb, msg, len) != SUCCESS);
+    }
+
+    return NULL;
+}
+
+void *reader(void *arg)
+{
+    rbctx_t *rb = arg;
+    unsigned char buf[SLOT_SIZE];
+
+    while (atomic_load(&total_received) < NUMBER_OF_MESSAGES) {
+        size_t len = sizeof(buf);
+        if (ringbuffer_read(rb, buf, &len) != SUCCESS) {
+            continue;
+        }
+        int idx;
+        memcpy(&idx, buf, sizeof(int));
+        if (idx < 0 || idx >= NUMBER_OF_MESSAGES || len != sizeof(int) + idx % (SLOT_SIZE - sizeof(int) + 1)) {
+            printf("Error: corrupted message\n");
+            exit(1);
+        }
+        for (size_t j = sizeof(int); j < len; j++) {
+            if (buf[j] != 'a' + idx % 26) {
+                printf("Error: corrupted payload of message %d\n", idx);
+                exit(1);
+            }
+        }
+        atomic_fetch_add(&received[idx], 1);
+        atomic_fetch_add(&total_received, 1);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_MPMC;
+    attr.slot_size = SLOT_SIZE;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+    /* slots are cache-line aligned */
+    if (ringbuffer_context->slot_count == 0 ||
+        (uintptr_t) ringbuffer_context->slots % RB_CACHE_LINE != 0 ||
+        ringbuffer_context->slot_stride % RB_CACHE_LINE != 0) {
+        printf("Error: invalid slot layout\n");
+        exit(1);
+    }
+
+    /* a message larger than a slot can never be written */
+    unsigned char big[SLOT_SIZE + 1];
+    if (ringbuffer_write(ringbuffer_context, big, sizeof(big)) != RINGBUFFER_FULL) {
+        printf("Error: expected RINGBUFFER_FULL for oversized message\n");
+        exit(1);
+    }
+
+    printf("creating reader and writer threads\n");
+    pthread_t w_ids[NUMBER_OF_WRITERS], r_ids[NUMBER_OF_READERS];
+    args_t w_args[NUMBER_OF_WRITERS];
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_create(&r_ids[i], NULL, reader, ringbuffer_context);
+    }
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        w_args[i].rb = ringbuffer_context;
+        w_args[i].from = i * (NUMBER_OF_MESSAGES / NUMBER_OF_WRITERS);
+        w_args[i].to = (i + 1) * (NUMBER_OF_MESSAGES / NUMBER_OF_WRITERS);
+        pthread_create(&w_ids[i], NULL, writer, &w_args[i]);
+    }
+
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        pthread_join(w_ids[i], NULL);
+    }
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_join(r_ids[i], NULL);
+    }
+
+    printf("comparing results\n");
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (received[i] != 1) {
+            printf("Error: message %d received %d times\n", i, received[i]);
+            exit(1);
+        }
+    }
+
+    ringbuffer_destroy(ringbuffer_context);
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("Test passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+
+#define NUMBER_OF_STRINGS 10000
+#define BUF_SIZE 50  // bytes
+#define RBUF_SIZE 128  // bytes
+
+/********************************************************************
+* Same workload as test_threaded, but with exactly one writer and
+* one reader on a RB_MODE_SPSC ringbuffer. With a single consumer
+* the strings have to arrive in exactly the order they were written.
+*********************************************************************/
+
+typedef struct {
+    rbctx_t *rb;
+    char** strings;
+} args_t;
+
+void *writer(void *arg)
+{
+    rbctx_t *rb = ((args_t *)arg)->rb;
+    char** strings = ((args_t *)arg)->strings;
+
+    for (int i = 0; i < NUMBER_OF_STRINGS; i++) {
+        size_t str_len = strlen(strings[i]) + 1;
+        while (ringbuffer_write(rb, strings[i], str_len) != SUCCESS);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    /* array of random strings */
+    char* strings[NUMBER_OF_STRINGS];
+    for (int i = 0; i < NUMBER_OF_STRINGS; i++) {
+        int len = rand() % BUF_SIZE;
+        char* str = malloc(len + 1);
+        if (str == NULL) {
+            printf("Error: malloc failed\n");
+            exit(1);
+        }
+        for (int j = 0; j < len; j++) {
+            str[j] = 'a' + (rand() % 26);
+        }
+        str[len] = '\0';
+        strings[i] = str;
+    }
+
+    /* initialize ringbuffer in spsc mode */
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_SPSC;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+    /* a too small output buffer must not consume the message */
+    char small[2];
+    size_t small_len = sizeof(small);
+    if (ringbuffer_write(ringbuffer_context, "hello", 6) != SUCCESS ||
+        ringbuffer_read(ringbuffer_context, small, &small_len) != OUTPUT_BUFFER_TOO_SMALL) {
+        printf("Error: expected OUTPUT_BUFFER_TOO_SMALL\n");
+        exit(1);
+    }
+    char hello[BUF_SIZE];
+    size_t hello_len = sizeof(hello);
+    if (ringbuffer_read(ringbuffer_context, hello, &hello_len) != SUCCESS ||
+        hello_len != 6 || strcmp(hello, "hello") != 0) {
+        printf("Error: message was lost after OUTPUT_BUFFER_TOO_SMALL\n");
+        exit(1);
+    }
+
+    printf("creating writer thread\n");
+    args_t w_args = {ringbuffer_context, (char**) strings};
+    pthread_t w_id;
+    pthread_create(&w_id, NULL, writer, &w_args);
+
+    printf("reading in main thread\n");
+    unsigned char buf[BUF_SIZE];
+    for (int i = 0; i < NUMBER_OF_STRINGS; i++) {
+        size_t read = BUF_SIZE;
+        while (ringbuffer_read(ringbuffer_context, buf, &read) != SUCCESS) {
+            read = BUF_SIZE;
+        }
+        if (read != strlen(strings[i]) + 1 || strcmp((char*) buf, strings[i]) != 0) {
+            printf("Error: string %d out of order or corrupted\n", i);
+            printf("Expected: %s\n", strings[i]);
+            printf("Got: %s\n", buf);
+            exit(1);
+        }
+    }
+
+    pthread_join(w_id, NULL);
+
+    /* free resources */
+    ringbuffer_destroy(ringbuffer_context);
+    free(rbuf);
+    free(ringbuffer_context);
+    for (int i = 0; i < NUMBER_OF_STRINGS; i++) {
+        free(strings[i]);
+    }
+
+    printf("Test passed!\n");
+
+    return 0;
+}
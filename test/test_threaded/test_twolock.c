@@ -0,0 +1,210 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+
+#define NUMBER_OF_MESSAGES 40000
+#define NUMBER_OF_WRITERS 4
+#define NUMBER_OF_READERS 4
+#define MAX_MESSAGE_SIZE 48  // bytes
+#define RBUF_SIZE 1024  // bytes
+
+/********************************************************************
+* Several writers and readers on a RB_MODE_TWOLOCK ringbuffer. Writers
+* alternate between copying writes and reserve/commit, readers between
+* copying reads, peek/release and batches. Every message has to arrive
+* exactly once, and each reader has to see the messages of a writer in
+* the order they were written.
+*********************************************************************/
+
+_Atomic int received[NUMBER_OF_MESSAGES];
+_Atomic int total_received = 0;
+
+typedef struct {
+    rbctx_t *rb;
+    int from;
+    int to;
+} args_t;
+
+static size_t message_len(int idx)
+{
+    return sizeof(int) + idx % (MAX_MESSAGE_SIZE - sizeof(int) + 1);
+}
+
+void *writer(void *arg)
+{
+    args_t *args = arg;
+    unsigned char msg[MAX_MESSAGE_SIZE];
+
+    for (int i = args->from; i < args->to; i++) {
+        size_t len = message_len(i);
+        memcpy(msg, &i, sizeof(int));
+        memset(msg + sizeof(int), 'a' + i % 26, len - sizeof(int));
+        if (i % 2 == 0) {
+            while (ringbuffer_write_timed(args->rb, msg, len, RB_TIMEOUT_INFINITE) != SUCCESS);
+        } else {
+            rbspan_t span;
+            while (ringbuffer_write_reserve_timed(args->rb, len, &span, RB_TIMEOUT_INFINITE) != SUCCESS);
+            ringbuffer_span_write(&span, 0, msg, len);
+            ringbuffer_write_commit(args->rb, &span, len);
+        }
+    }
+
+    return NULL;
+}
+
+static void check(unsigned char *buf, size_t len, int *last)
+{
+    int idx;
+    memcpy(&idx, buf, sizeof(int));
+    if (idx < 0 || idx >= NUMBER_OF_MESSAGES || len != message_len(idx)) {
+        printf("Error: corrupted message\n");
+        exit(1);
+    }
+    for (size_t j = sizeof(int); j < len; j++) {
+        if (buf[j] != 'a' + idx % 26) {
+            printf("Error: corrupted payload of message %d\n", idx);
+            exit(1);
+        }
+    }
+    int w = idx / (NUMBER_OF_MESSAGES / NUMBER_OF_WRITERS);
+    if (idx <= last[w]) {
+        printf("Error: message %d of writer %d read after message %d\n", idx, w, last[w]);
+        exit(1);
+    }
+    last[w] = idx;
+    atomic_fetch_add(&received[idx], 1);
+    atomic_fetch_add(&total_received, 1);
+}
+
+void *reader(void *arg)
+{
+    rbctx_t *rb = arg;
+    unsigned char buf[4][MAX_MESSAGE_SIZE];
+    int last[NUMBER_OF_WRITERS];
+    for (int w = 0; w < NUMBER_OF_WRITERS; w++) {
+        last[w] = -1;
+    }
+
+    for (unsigned round = 0; atomic_load(&total_received) < NUMBER_OF_MESSAGES; round++) {
+        if (round % 3 == 0) {
+            size_t len = sizeof(buf[0]);
+            if (ringbuffer_read_timed(rb, buf[0], &len, 1000000) == SUCCESS) {
+                check(buf[0], len, last);
+            }
+        } else if (round % 3 == 1) {
+            rbspan_t span;
+            if (ringbuffer_read_peek_timed(rb, &span, 1000000) == SUCCESS) {
+                size_t len = span.len[0] + span.len[1];
+                ringbuffer_span_read(&span, 0, buf[0], len);
+                ringbuffer_read_release(rb, &span);
+                check(buf[0], len, last);
+            }
+        } else {
+            void *buffers[4] = {buf[0], buf[1], buf[2], buf[3]};
+            size_t lens[4];
+            size_t count;
+            for (int k = 0; k < 4; k++) {
+                lens[k] = sizeof(buf[k]);
+            }
+            ringbuffer_read_batch(rb, buffers, lens, 4, 0, &count);
+            for (size_t k = 0; k < count; k++) {
+                check(buf[k], lens[k], last);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_TWOLOCK;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+    /* cursors over a power-of-two ring, waiting on condition variables by default */
+    if (ringbuffer_context->mask != RBUF_SIZE - 1 || ringbuffer_context->wait != RB_WAIT_CONDVAR) {
+        printf("Error: unexpected ring setup\n");
+        exit(1);
+    }
+
+    /* a reservation holds the writer side only, readers go on meanwhile */
+    rbspan_t span;
+    int one = 1;
+    unsigned char buf[MAX_MESSAGE_SIZE];
+    size_t len = sizeof(buf);
+    ringbuffer_write_timed(ringbuffer_context, &one, sizeof(one), RB_TIMEOUT_TRY);
+    if (ringbuffer_write_reserve_timed(ringbuffer_context, sizeof(one), &span, RB_TIMEOUT_TRY) != SUCCESS ||
+        ringbuffer_read_timed(ringbuffer_context, buf, &len, RB_TIMEOUT_TRY) != SUCCESS || len != sizeof(one)) {
+        printf("Error: read blocked by a reservation\n");
+        exit(1);
+    }
+    ringbuffer_write_cancel(ringbuffer_context, &span);
+    len = sizeof(buf);
+    if (ringbuffer_read_timed(ringbuffer_context, buf, &len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY) {
+        printf("Error: cancelled reservation was published\n");
+        exit(1);
+    }
+
+    /* a message that stays in the ring after a too small read */
+    ringbuffer_write_timed(ringbuffer_context, &one, sizeof(one), RB_TIMEOUT_TRY);
+    len = 1;
+    if (ringbuffer_read_timed(ringbuffer_context, buf, &len, RB_TIMEOUT_TRY) != OUTPUT_BUFFER_TOO_SMALL) {
+        printf("Error: expected OUTPUT_BUFFER_TOO_SMALL\n");
+        exit(1);
+    }
+    len = sizeof(buf);
+    if (ringbuffer_read_timed(ringbuffer_context, buf, &len, RB_TIMEOUT_TRY) != SUCCESS) {
+        printf("Error: message lost after a too small read\n");
+        exit(1);
+    }
+
+    printf("creating reader and writer threads\n");
+    pthread_t w_ids[NUMBER_OF_WRITERS], r_ids[NUMBER_OF_READERS];
+    args_t w_args[NUMBER_OF_WRITERS];
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_create(&r_ids[i], NULL, reader, ringbuffer_context);
+    }
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        w_args[i].rb = ringbuffer_context;
+        w_args[i].from = i * (NUMBER_OF_MESSAGES / NUMBER_OF_WRITERS);
+        w_args[i].to = (i + 1) * (NUMBER_OF_MESSAGES / NUMBER_OF_WRITERS);
+        pthread_create(&w_ids[i], NULL, writer, &w_args[i]);
+    }
+
+    for (int i = 0; i < NUMBER_OF_WRITERS; i++) {
+        pthread_join(w_ids[i], NULL);
+    }
+    for (int i = 0; i < NUMBER_OF_READERS; i++) {
+        pthread_join(r_ids[i], NULL);
+    }
+
+    printf("comparing results\n");
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (received[i] != 1) {
+            printf("Error: message %d received %d times\n", i, received[i]);
+            exit(1);
+        }
+    }
+
+    ringbuffer_destroy(ringbuffer_context);
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("Test passed!\n");
+
+    return 0;
+}
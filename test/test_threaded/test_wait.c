@@ -0,0 +1,129 @@
+#include "../include/ringbuf.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+
+#define NUMBER_OF_MESSAGES 5000
+#define RBUF_SIZE 1024  // bytes
+#define SLOT_SIZE 32    // bytes
+#define SHORT_TIMEOUT 50000000  // 50 ms
+
+/********************************************************************
+* Every mode with every wait strategy: try-only and timed calls give
+* up on an empty or full ring after the requested time, and one
+* writer and one reader with infinite timeouts hand over a stream of
+* numbered messages in order.
+*********************************************************************/
+
+static int64_t elapsed_ns(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - start->tv_sec) * 1000000000 + (now.tv_nsec - start->tv_nsec);
+}
+
+void *writer(void *arg)
+{
+    rbctx_t *rb = arg;
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (ringbuffer_write_timed(rb, &i, sizeof(i), RB_TIMEOUT_INFINITE) != SUCCESS) {
+            printf("Error: write with infinite timeout failed\n");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+void *reader(void *arg)
+{
+    rbctx_t *rb = arg;
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        int value;
+        size_t len = sizeof(value);
+        if (ringbuffer_read_timed(rb, &value, &len, RB_TIMEOUT_INFINITE) != SUCCESS ||
+            len != sizeof(value) || value != i) {
+            printf("Error: expected message %d\n", i);
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+int main()
+{
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+    rbwait_t waits[] = {RB_WAIT_CONDVAR, RB_WAIT_SPIN, RB_WAIT_SPIN_YIELD, RB_WAIT_FUTEX};
+    const char *wait_names[] = {"condvar", "spin", "spin-yield", "futex"};
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.slot_size = SLOT_SIZE;
+
+    for (int m = 0; m < 3; m++) {
+        for (int w = 0; w < 4; w++) {
+            attr.mode = modes[m];
+            attr.wait = waits[w];
+            ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+            printf("mode %d, %s\n", m, wait_names[w]);
+
+            /* an empty ring: try-only returns at once, a timed read after the timeout */
+            char buffer[SLOT_SIZE];
+            size_t buffer_len = sizeof(buffer);
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY ||
+                elapsed_ns(&start) > SHORT_TIMEOUT) {
+                printf("Error: try-only read did not return RINGBUFFER_EMPTY at once\n");
+                exit(1);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, SHORT_TIMEOUT) != RINGBUFFER_EMPTY ||
+                elapsed_ns(&start) < SHORT_TIMEOUT || elapsed_ns(&start) > RB_TIMEOUT_DEFAULT) {
+                printf("Error: timed read did not wait for its timeout\n");
+                exit(1);
+            }
+
+            /* a full ring: try-only and timed writes give up */
+            memset(buffer, 'x', sizeof(buffer));
+            while (ringbuffer_write_timed(ringbuffer_context, buffer, sizeof(buffer), RB_TIMEOUT_TRY) == SUCCESS);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (ringbuffer_write_timed(ringbuffer_context, buffer, sizeof(buffer), SHORT_TIMEOUT) != RINGBUFFER_FULL ||
+                elapsed_ns(&start) < SHORT_TIMEOUT || elapsed_ns(&start) > RB_TIMEOUT_DEFAULT) {
+                printf("Error: timed write did not wait for its timeout\n");
+                exit(1);
+            }
+            buffer_len = sizeof(buffer);
+            while (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY) == SUCCESS) {
+                buffer_len = sizeof(buffer);
+            }
+
+            /* one writer, one reader, both waiting without a timeout */
+            pthread_t w_id, r_id;
+            pthread_create(&r_id, NULL, reader, ringbuffer_context);
+            pthread_create(&w_id, NULL, writer, ringbuffer_context);
+            pthread_join(w_id, NULL);
+            pthread_join(r_id, NULL);
+
+            ringbuffer_destroy(ringbuffer_context);
+        }
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("Test passed!\n");
+
+    return 0;
+}
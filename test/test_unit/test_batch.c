@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+#define BATCH 4
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    char *msg[] = {"first", "second message", "third", "fourth", "fifth"};
+    size_t rbuf_size = 1024;
+    char* rbuf = malloc(rbuf_size);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    char bufs[BATCH][32];
+    void *buffers[BATCH];
+    size_t buffer_lens[BATCH];
+    size_t count;
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.slot_size = 32;
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+
+    for (int m = 0; m < 3; m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, rbuf_size, &attr);
+        printf("--------------------------------------------------------\n");
+        printf("Mode %d\n", m);
+
+        for (int i = 0; i < 5; i++) {
+            if (ringbuffer_write(ringbuffer_context, msg[i], strlen(msg[i]) + 1) != SUCCESS) {
+                printf("Error: write failed\n");
+                exit(1);
+            }
+        }
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * a batch stops at max_messages                                         *
+         *************************************************************************/
+        for (int i = 0; i < BATCH; i++) {
+            buffers[i] = bufs[i];
+            buffer_lens[i] = sizeof(bufs[i]);
+        }
+        if (ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, 3, 0, &count) != SUCCESS || count != 3) {
+            printf("Error: Test 1 failed. Expected a batch of 3\n");
+            exit(1);
+        }
+        for (int i = 0; i < 3; i++) {
+            if (buffer_lens[i] != strlen(msg[i]) + 1 || strcmp(bufs[i], msg[i]) != 0) {
+                printf("Error: Test 1 failed. Message %d does not match\n", i);
+                exit(1);
+            }
+        }
+        printf("  + Test 1 passed\n");
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * a batch stops at a buffer that is too small and at the byte budget    *
+         *************************************************************************/
+        for (int i = 0; i < BATCH; i++) {
+            buffer_lens[i] = sizeof(bufs[i]);
+        }
+        buffer_lens[0] = 2;
+        if (ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, BATCH, 0, &count) != OUTPUT_BUFFER_TOO_SMALL || count != 0) {
+            printf("Error: Test 2.1 failed. Expected OUTPUT_BUFFER_TOO_SMALL\n");
+            exit(1);
+        }
+        buffer_lens[0] = sizeof(bufs[0]);
+        if (ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, BATCH, 8, &count) != SUCCESS || count != 1 ||
+            strcmp(bufs[0], msg[3]) != 0) {
+            printf("Error: Test 2.2 failed. Expected only the fourth message within the budget\n");
+            exit(1);
+        }
+        buffer_lens[0] = sizeof(bufs[0]);
+        if (ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, BATCH, 0, &count) != SUCCESS || count != 1 ||
+            strcmp(bufs[0], msg[4]) != 0) {
+            printf("Error: Test 2.3 failed. Expected the fifth message\n");
+            exit(1);
+        }
+        printf("  + Test 2 passed\n");
+
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * an empty ring times out                                               *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    ringbuffer_init(ringbuffer_context, rbuf, rbuf_size);
+    buffer_lens[0] = sizeof(bufs[0]);
+    if (ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, BATCH, 0, &count) != RINGBUFFER_EMPTY || count != 0) {
+        printf("Error: Test 3 failed. Expected RINGBUFFER_EMPTY\n");
+        exit(1);
+    }
+    if (ringbuffer_read_batch_timed(ringbuffer_context, buffers, buffer_lens, BATCH, 0, &count,
+                                    RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY || count != 0) {
+        printf("Error: Test 3 failed. Expected RINGBUFFER_EMPTY without waiting\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 3 passed\n");
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
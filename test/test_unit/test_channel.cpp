@@ -0,0 +1,152 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "../include/ringbuf_channel.hpp"
+
+#define CAPACITY 16
+#define NUMBER_OF_MESSAGES 100000
+
+struct point {
+    int x, y, z; // 12 bytes, padded to a 16-byte record in RB_MODE_SPSC
+};
+
+/* counts live instances, to check that the channel destroys what it still holds */
+struct tracked {
+    static int live;
+    std::unique_ptr<std::string> name;
+    explicit tracked(const char *s) : name(std::make_unique<std::string>(s)) { live++; }
+    tracked(tracked &&other) noexcept : name(std::move(other.name)) { live++; }
+    tracked &operator=(tracked &&other) noexcept = default;
+    ~tracked() { live--; }
+};
+int tracked::live = 0;
+
+/* throws from its constructor when asked to */
+struct fragile {
+    std::string s;
+    explicit fragile(bool fail) : s("fragile") {
+        if (fail) {
+            throw std::runtime_error("constructor failed");
+        }
+    }
+};
+
+int main() {
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * trivially copyable values: exactly Capacity fit, FIFO order           *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: trivially copyable values\n");
+    {
+        auto ch = std::make_unique<ringbuf::channel<point, CAPACITY>>();
+        static_assert(ringbuf::channel<point, CAPACITY>::record_size == sizeof(point));
+        for (int i = 0; i < CAPACITY; i++) {
+            if (ch->push(point{i, -i, 2 * i}, RB_TIMEOUT_TRY) != SUCCESS) {
+                printf("Error: Test 1 failed. Push %d failed\n", i);
+                exit(1);
+            }
+        }
+        if (ch->push(point{0, 0, 0}, RB_TIMEOUT_TRY) != RINGBUFFER_FULL) {
+            printf("Error: Test 1 failed. More than the capacity fit\n");
+            exit(1);
+        }
+        for (int i = 0; i < CAPACITY; i++) {
+            point p;
+            if (ch->pop(p, RB_TIMEOUT_TRY) != SUCCESS || p.x != i || p.y != -i || p.z != 2 * i) {
+                printf("Error: Test 1 failed. Value %d lost or out of order\n", i);
+                exit(1);
+            }
+        }
+        point p;
+        rbstats_t stats;
+        ringbuffer_get_stats(ch->native_handle(), &stats);
+        if (ch->pop(p, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY || stats.bytes_written != CAPACITY * sizeof(point)) {
+            printf("Error: Test 1 failed. Channel not empty or no length-free records\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * lock-free channel between two threads, padded records                 *
+     *************************************************************************/
+    printf("Test 2: SPSC channel\n");
+    {
+        using spsc_channel = ringbuf::channel<point, CAPACITY, RB_MODE_SPSC>;
+        static_assert(spsc_channel::record_size == 16);
+        auto ch = std::make_unique<spsc_channel>();
+        std::thread producer([&ch] {
+            for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+                ch->push(point{i, i + 1, i + 2}, RB_TIMEOUT_INFINITE);
+            }
+        });
+        for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+            point p;
+            if (ch->pop(p, RB_TIMEOUT_INFINITE) != SUCCESS || p.x != i || p.y != i + 1 || p.z != i + 2) {
+                printf("Error: Test 2 failed. Value %d lost or out of order\n", i);
+                exit(1);
+            }
+        }
+        producer.join();
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * non-trivial values are moved, leftovers destroyed with the channel    *
+     *************************************************************************/
+    printf("Test 3: move-only values\n");
+    {
+        ringbuf::channel<tracked, CAPACITY> ch;
+        tracked first("first");
+        if (ch.push(std::move(first)) != SUCCESS || first.name != nullptr ||
+            ch.emplace_timed(RB_TIMEOUT_TRY, "second") != SUCCESS ||
+            ch.emplace_timed(RB_TIMEOUT_TRY, "third") != SUCCESS) {
+            printf("Error: Test 3 failed. Push did not move\n");
+            exit(1);
+        }
+        tracked out("out");
+        if (ch.pop(out) != SUCCESS || *out.name != "first" || tracked::live != 4) {
+            printf("Error: Test 3 failed. Pop did not move, %d live\n", tracked::live);
+            exit(1);
+        }
+    }
+    if (tracked::live != 0) {
+        printf("Error: Test 3 failed. %d values leaked\n", tracked::live);
+        exit(1);
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * a throwing constructor cancels its record                             *
+     *************************************************************************/
+    printf("Test 4: throwing constructor\n");
+    {
+        ringbuf::channel<fragile, CAPACITY> ch;
+        int thrown = 0;
+        try {
+            ch.emplace_timed(RB_TIMEOUT_TRY, true);
+        } catch (const std::runtime_error &) {
+            thrown = 1;
+        }
+        fragile out(false);
+        out.s.clear();
+        if (!thrown || ch.pop(out, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY ||
+            ch.emplace_timed(RB_TIMEOUT_TRY, false) != SUCCESS ||
+            ch.pop(out, RB_TIMEOUT_TRY) != SUCCESS || out.s != "fragile") {
+            printf("Error: Test 4 failed\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 4 passed\n");
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,257 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ringbuf_coro.hpp"
+
+#define CAPACITY 4
+#define THREADS 4
+#define COROUTINES 1000          // producers, and as many consumers
+#define MESSAGES_PER_COROUTINE 100
+
+/* a coroutine that starts right away and cleans up after itself */
+struct detached {
+    struct promise_type {
+        detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/* a handful of threads resuming whatever coroutine is handed to them */
+class thread_pool {
+public:
+    explicit thread_pool(int threads) {
+        for (int i = 0; i < threads; i++) {
+            threads_.emplace_back([this] { run(); });
+        }
+    }
+    ~thread_pool() {
+        {
+            std::lock_guard lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : threads_) {
+            t.join();
+        }
+    }
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard lock(mtx_);
+            queue_.push_back(handle);
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::unique_lock lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            auto handle = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            handle.resume();
+        }
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<std::coroutine_handle<>> queue_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+struct pool_scheduler {
+    thread_pool *pool;
+    void schedule(std::coroutine_handle<> handle) const { pool->post(handle); }
+};
+
+using inline_channel = ringbuf::async_channel<std::string, CAPACITY>;
+using long_channel = ringbuf::async_channel<long, CAPACITY>;
+using pool_channel = ringbuf::async_channel<long, CAPACITY, RB_MODE_LOCKED, pool_scheduler>;
+
+template <class Channel, class T>
+detached pop_one(Channel &ch, T &out) {
+    out = co_await ch.async_pop();
+}
+
+detached push_one(inline_channel &ch, std::string value, bool &done) {
+    co_await ch.async_push(std::move(value));
+    done = true;
+}
+
+std::atomic<long> sum{0};
+std::atomic<int> finished{0};
+
+detached produce(pool_channel &ch, long from) {
+    for (long i = from; i < from + MESSAGES_PER_COROUTINE; i++) {
+        co_await ch.async_push(i);
+    }
+    finished++;
+}
+
+detached consume(pool_channel &ch) {
+    for (int i = 0; i < MESSAGES_PER_COROUTINE; i++) {
+        sum += co_await ch.async_pop();
+    }
+    finished++;
+}
+
+int main() {
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * a pop on the empty channel suspends until a value arrives             *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: suspended pop\n");
+    {
+        auto ch = std::make_unique<inline_channel>();
+        std::string out;
+        pop_one(*ch, out);
+        if (!out.empty()) {
+            printf("Error: Test 1 failed. Pop did not suspend\n");
+            exit(1);
+        }
+        ch->try_push(std::string("first"));
+        if (out != "first") {
+            printf("Error: Test 1 failed. Pop not completed by the push\n");
+            exit(1);
+        }
+        std::string left;
+        if (ch->try_pop(left) != RINGBUFFER_EMPTY) {
+            printf("Error: Test 1 failed. The value was delivered twice\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * a push on the full channel suspends until a record is free            *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 2: suspended push\n");
+    {
+        auto ch = std::make_unique<inline_channel>();
+        for (int i = 0; i < CAPACITY; i++) {
+            ch->try_push(std::to_string(i));
+        }
+        bool done = false;
+        push_one(*ch, "last", done);
+        if (done) {
+            printf("Error: Test 2 failed. Push did not suspend\n");
+            exit(1);
+        }
+        std::string value;
+        ch->try_pop(value);
+        if (!done || value != "0") {
+            printf("Error: Test 2 failed. Push not completed by the pop\n");
+            exit(1);
+        }
+        for (int i = 1; i <= CAPACITY; i++) {
+            if (ch->try_pop(value) != SUCCESS || value != (i < CAPACITY ? std::to_string(i) : "last")) {
+                printf("Error: Test 2 failed. Values out of order\n");
+                exit(1);
+            }
+        }
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * suspended pops complete in the order they suspended                   *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 3: suspended coroutines are served in order\n");
+    {
+        auto ch = std::make_unique<inline_channel>();
+        std::string out[3];
+        for (auto &o : out) {
+            pop_one(*ch, o);
+        }
+        ch->try_push(std::string("a"));
+        ch->try_push(std::string("b"));
+        if (out[0] != "a" || out[1] != "b" || !out[2].empty()) {
+            printf("Error: Test 3 failed. Pops served out of order\n");
+            exit(1);
+        }
+        ch->try_push(std::string("c"));
+        if (out[2] != "c") {
+            printf("Error: Test 3 failed. Last pop not served\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * a value that reaches the ring behind the channel's back (no wakeup)   *
+     * still goes to the suspended pop, not to a later one                   *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 4: later operations queue behind suspended ones\n");
+    {
+        auto ch = std::make_unique<long_channel>();
+        long first = 0, second = 0, value = 1;
+        pop_one(*ch, first);
+        ringbuffer_write(ch->native_handle(), &value, sizeof(value));
+        long taken;
+        if (ch->try_pop(taken) != RINGBUFFER_EMPTY) {
+            printf("Error: Test 4 failed. try_pop overtook a suspended pop\n");
+            exit(1);
+        }
+        pop_one(*ch, second); // queues behind the first pop, which then takes the value
+        if (first != 1 || second != 0) {
+            printf("Error: Test 4 failed. A pop overtook a suspended pop\n");
+            exit(1);
+        }
+        ch->try_push(2);
+        if (first != 1 || second != 2) {
+            printf("Error: Test 4 failed. Pops served out of order\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 4 passed\n");
+
+    /*************************************************************************
+     * TEST 5:                                                               *
+     * thousands of coroutines on a handful of threads                       *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 5: %d producers and %d consumers on %d threads\n", COROUTINES, COROUTINES, THREADS);
+    {
+        thread_pool pool(THREADS);
+        auto ch = std::make_unique<pool_channel>(pool_scheduler{&pool});
+        for (int i = 0; i < COROUTINES; i++) {
+            produce(*ch, (long) i * MESSAGES_PER_COROUTINE);
+            consume(*ch);
+        }
+        while (finished.load() < 2 * COROUTINES) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        long n = (long) COROUTINES * MESSAGES_PER_COROUTINE;
+        if (sum.load() != n * (n - 1) / 2) {
+            printf("Error: Test 5 failed. Sum %ld instead of %ld\n", sum.load(), n * (n - 1) / 2);
+            exit(1);
+        }
+    }
+    printf("  + Test 5 passed\n");
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
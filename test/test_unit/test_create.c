@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 100000
+#define MSG_LEN 100
+#define NUMBER_OF_MESSAGES 5000
+
+/* number of pages of the ring that are resident */
+size_t resident_pages(const rbctx_t *ctx) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t pages = ctx->map_size / page;
+    unsigned char *vec = malloc(pages);
+    size_t resident = 0;
+    if (vec != NULL && mincore(ctx->begin, ctx->map_size, vec) == 0) {
+        for (size_t i = 0; i < pages; i++) {
+            resident += vec[i] & 1;
+        }
+    }
+    free(vec);
+    return resident;
+}
+
+/* write and read NUMBER_OF_MESSAGES messages through the ring, several laps */
+int round_trip(rbctx_t *ctx) {
+    char msg[MSG_LEN];
+    char buffer[MSG_LEN];
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        memset(msg, i & 0xff, MSG_LEN);
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_write(ctx, msg, MSG_LEN) != SUCCESS ||
+            ringbuffer_read(ctx, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != MSG_LEN || memcmp(msg, buffer, MSG_LEN) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    rbmem_t mem;
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * default mapping: whole pages, faulted in on first touch               *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: default mapping\n");
+    if (ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, NULL) != SUCCESS) {
+        printf("Error: Test 1 failed. Could not create\n");
+        exit(1);
+    }
+    size_t size = ringbuffer_context->end - ringbuffer_context->begin;
+    if (size < RBUF_SIZE || size % page != 0 || ringbuffer_context->storage != RB_STORAGE_MAPPED ||
+        resident_pages(ringbuffer_context) != 0) {
+        printf("Error: Test 1 failed. size %zu, %zu pages resident\n", size, resident_pages(ringbuffer_context));
+        exit(1);
+    }
+    if (!round_trip(ringbuffer_context)) {
+        printf("Error: Test 1 failed. Messages corrupted\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * prefaulted and locked: every page resident before the first write     *
+     *************************************************************************/
+    printf("Test 2: prefault and mlock\n");
+    ringbuffer_mem_init(&mem);
+    mem.prefault = 1;
+    mem.lock = 1;
+    int res = ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, &mem);
+    if (res == EPERM || res == ENOMEM || res == EAGAIN) {
+        // RLIMIT_MEMLOCK too small, prefault alone
+        printf("  (mlock not permitted, prefault only)\n");
+        mem.lock = 0;
+        res = ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, &mem);
+    }
+    if (res != SUCCESS || resident_pages(ringbuffer_context) != ringbuffer_context->map_size / page ||
+        !round_trip(ringbuffer_context)) {
+        printf("Error: Test 2 failed. %zu of %zu pages resident\n",
+               resident_pages(ringbuffer_context), ringbuffer_context->map_size / page);
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * huge pages: aligned transparent mapping, hugetlb if pages are reserved *
+     *************************************************************************/
+    printf("Test 3: huge pages\n");
+    ringbuffer_mem_init(&mem);
+    mem.pages = RB_PAGES_TRANSPARENT;
+    attr.mode = RB_MODE_SPSC;
+    if (ringbuffer_create(ringbuffer_context, RBUF_SIZE, &attr, &mem) != SUCCESS ||
+        (uintptr_t) ringbuffer_context->begin % RB_HUGE_PAGE_SIZE != 0 ||
+        ringbuffer_context->map_size != RB_HUGE_PAGE_SIZE ||
+        ringbuffer_context->mask + 1 != RB_HUGE_PAGE_SIZE || !round_trip(ringbuffer_context)) {
+        printf("Error: Test 3 failed. Transparent huge page mapping\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    attr.mode = RB_MODE_LOCKED;
+    mem.pages = RB_PAGES_HUGETLB;
+    res = ringbuffer_create(ringbuffer_context, RBUF_SIZE, &attr, &mem);
+    if (res == SUCCESS) {
+        if (ringbuffer_context->map_size != RB_HUGE_PAGE_SIZE || !round_trip(ringbuffer_context)) {
+            printf("Error: Test 3 failed. hugetlb mapping\n");
+            exit(1);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+    } else if (res != ENOMEM && res != ENOTSUP) {
+        printf("Error: Test 3 failed. hugetlb returned %d\n", res);
+        exit(1);
+    } else {
+        printf("  (no huge pages reserved, hugetlb skipped)\n");
+    }
+    mem.huge_page_size = 3 << 20;
+    if (ringbuffer_create(ringbuffer_context, RBUF_SIZE, &attr, &mem) != EINVAL) {
+        printf("Error: Test 3 failed. Accepted a bad huge page size\n");
+        exit(1);
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * NUMA binding: node 0 always exists, unknown nodes are rejected        *
+     *************************************************************************/
+    printf("Test 4: NUMA binding\n");
+    ringbuffer_mem_init(&mem);
+    mem.numa_node = 0;
+    mem.prefault = 1;
+    res = ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, &mem);
+    if (res == SUCCESS) {
+        if (!round_trip(ringbuffer_context)) {
+            printf("Error: Test 4 failed. Messages corrupted\n");
+            exit(1);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+        mem.numa_node = 1000;
+        if (ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, &mem) != EINVAL) {
+            printf("Error: Test 4 failed. Bound to a node that does not exist\n");
+            exit(1);
+        }
+    } else if (res == ENOSYS || res == EPERM) {
+        printf("  (mbind not available, skipped)\n");
+    } else {
+        printf("Error: Test 4 failed. mbind returned %d\n", res);
+        exit(1);
+    }
+    mem.numa_node = -2;
+    if (ringbuffer_create(ringbuffer_context, RBUF_SIZE, NULL, &mem) != EINVAL) {
+        printf("Error: Test 4 failed. Accepted a bad node\n");
+        exit(1);
+    }
+    printf("  + Test 4 passed\n");
+
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 100 // RB_MODE_SPSC uses the largest power of two that fits
+#define MSG_LEN 13    // frames keep straddling the end of the ring
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[MSG_LEN];
+    char buffer[MSG_LEN];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_SPSC;
+    attr.framing = RB_FRAME_U16;
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * capacity is a power of two and every byte of it can be used           *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: power-of-two capacity\n");
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    if (ringbuffer_context->end - ringbuffer_context->begin != 64 || ringbuffer_context->mask != 63) {
+        printf("Error: Test 1 failed. Expected 64 bytes, got %td\n",
+               ringbuffer_context->end - ringbuffer_context->begin);
+        exit(1);
+    }
+    // 4 frames of 14 bytes and one of 8 fill all 64 bytes
+    for (int i = 0; i < 4; i++) {
+        if (ringbuffer_write(ringbuffer_context, msg, 12) != SUCCESS) {
+            printf("Error: Test 1 failed. Write %d failed\n", i);
+            exit(1);
+        }
+    }
+    if (ringbuffer_write(ringbuffer_context, msg, 6) != SUCCESS ||
+        ringbuffer_write_timed(ringbuffer_context, msg, 0, RB_TIMEOUT_TRY) != RINGBUFFER_FULL) {
+        printf("Error: Test 1 failed. The last 8 bytes were not usable\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * cursors keep working when they overflow                               *
+     *************************************************************************/
+    printf("Test 2: cursor overflow\n");
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    // start just before the cursors wrap around zero, offset 64 - 7 in the ring
+    size_t start = SIZE_MAX - 6;
+    atomic_store(&ringbuffer_context->head, start);
+    atomic_store(&ringbuffer_context->tail, start);
+    ringbuffer_context->head_cache = start;
+    ringbuffer_context->tail_cache = start;
+    for (int i = 0; i < 100; i++) {
+        memset(msg, 'a' + i % 26, sizeof(msg));
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_write(ringbuffer_context, msg, MSG_LEN) != SUCCESS ||
+            ringbuffer_write(ringbuffer_context, msg, MSG_LEN) != SUCCESS ||
+            ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != MSG_LEN || memcmp(buffer, msg, MSG_LEN) != 0) {
+            printf("Error: Test 2 failed at message %d\n", i);
+            exit(1);
+        }
+        buffer_len = sizeof(buffer);
+        if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != MSG_LEN || memcmp(buffer, msg, MSG_LEN) != 0) {
+            printf("Error: Test 2 failed at message %d\n", i);
+            exit(1);
+        }
+    }
+    if (atomic_load(&ringbuffer_context->head) != start + 200 * (MSG_LEN + 2)) {
+        printf("Error: Test 2 failed. Unexpected head cursor\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 2 passed\n");
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../include/ringbuf_fanin.h"
+
+#define RBUF_SIZE 8192
+#define PRODUCERS 8
+#define THREADS 12     // more threads than rings, late ones wait for a freed ring
+#define CONSUMERS 3
+#define NUMBER_OF_MESSAGES 20000 // per thread
+#define BLOCKING_CONSUMERS 4
+#define BLOCKING_READS 10000     // per blocking consumer
+
+rbfanin_t *fanin;
+_Atomic int total_received = 0;
+_Atomic int received[THREADS][NUMBER_OF_MESSAGES];
+
+/* every thread registers its own ring, writes its numbers in order and leaves */
+void *produce(void *arg) {
+    int thread = (int)(intptr_t) arg;
+    unsigned id;
+    while (ringbuffer_fanin_register(fanin, &id) != SUCCESS) {
+        sched_yield();
+    }
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        int msg[2] = {thread, i};
+        if (ringbuffer_fanin_write(fanin, id, msg, sizeof(msg), RB_TIMEOUT_INFINITE) != SUCCESS) {
+            return (void *) 1;
+        }
+    }
+    ringbuffer_fanin_deregister(fanin, id);
+    return NULL;
+}
+
+/* every message arrives once, and each consumer sees the messages of a thread in order */
+void *consume(void *arg) {
+    (void) arg;
+    int last[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        last[t] = -1;
+    }
+    while (atomic_load(&total_received) < THREADS * NUMBER_OF_MESSAGES) {
+        int msg[2];
+        size_t len = sizeof(msg);
+        if (ringbuffer_fanin_read(fanin, msg, &len, 1000000, NULL) != SUCCESS) {
+            continue;
+        }
+        if (len != sizeof(msg) || msg[0] < 0 || msg[0] >= THREADS || msg[1] <= last[msg[0]] ||
+            msg[1] >= NUMBER_OF_MESSAGES || atomic_fetch_add(&received[msg[0]][msg[1]], 1) != 0) {
+            printf("Error: message %d of thread %d out of order or received twice\n", msg[1], msg[0]);
+            exit(1);
+        }
+        last[msg[0]] = msg[1];
+        atomic_fetch_add(&total_received, 1);
+    }
+    return NULL;
+}
+
+/* writes its share of the messages read by the blocking consumers */
+void *produce_share(void *arg) {
+    unsigned id = *(unsigned *) arg;
+    for (int i = 0; i < BLOCKING_CONSUMERS * BLOCKING_READS / 2; i++) {
+        if (ringbuffer_fanin_write(fanin, id, &i, sizeof(i), RB_TIMEOUT_INFINITE) != SUCCESS) {
+            return (void *) 1;
+        }
+    }
+    return NULL;
+}
+
+/* never gives up, a lost wakeup leaves it asleep with messages queued */
+void *consume_blocking(void *arg) {
+    (void) arg;
+    for (int i = 0; i < BLOCKING_READS; i++) {
+        int msg;
+        size_t len = sizeof(msg);
+        if (ringbuffer_fanin_read(fanin, &msg, &len, RB_TIMEOUT_INFINITE, NULL) != SUCCESS) {
+            return (void *) 1;
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    char *rbuf = malloc(RBUF_SIZE);
+    fanin = malloc(sizeof(rbfanin_t));
+    if (rbuf == NULL || fanin == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    unsigned ids[PRODUCERS];
+    unsigned producer;
+    int buffer[4];
+    size_t len;
+
+    if (ringbuffer_fanin_init(fanin, rbuf, RBUF_SIZE, RB_FANIN_MAX_PRODUCERS + 1, NULL) != EINVAL ||
+        ringbuffer_fanin_init(fanin, rbuf, RBUF_SIZE, 0, NULL) != EINVAL) {
+        printf("Error: invalid number of producers accepted\n");
+        exit(1);
+    }
+    ringbuffer_fanin_init(fanin, rbuf, RBUF_SIZE, PRODUCERS, NULL);
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * per-producer order, producers served round-robin                     *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: per-producer order and round-robin\n");
+    for (int p = 0; p < 3; p++) {
+        ringbuffer_fanin_register(fanin, &ids[p]);
+        for (int i = 0; i < 3; i++) {
+            int msg = p * 10 + i;
+            ringbuffer_fanin_write(fanin, ids[p], &msg, sizeof(msg), RB_TIMEOUT_TRY);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int p = 0; p < 3; p++) {
+            len = sizeof(buffer);
+            if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, &producer) != SUCCESS ||
+                len != sizeof(int) || producer != ids[p] || buffer[0] != p * 10 + i) {
+                printf("Error: Test 1 failed. Expected message %d of producer %d\n", i, p);
+                exit(1);
+            }
+        }
+    }
+    len = sizeof(buffer);
+    if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, NULL) != RINGBUFFER_EMPTY ||
+        ringbuffer_fanin_read(fanin, buffer, &len, 1000000, NULL) != RINGBUFFER_EMPTY ||
+        atomic_load(&fanin->ready) != 0) {
+        printf("Error: Test 1 failed. Fan-in not empty\n");
+        exit(1);
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * a message too large for the buffer stays                              *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 2: output buffer too small\n");
+    int pair[2] = {1, 2};
+    ringbuffer_fanin_write(fanin, ids[1], pair, sizeof(pair), RB_TIMEOUT_TRY);
+    len = sizeof(int);
+    if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, NULL) != OUTPUT_BUFFER_TOO_SMALL) {
+        printf("Error: Test 2 failed. Expected OUTPUT_BUFFER_TOO_SMALL\n");
+        exit(1);
+    }
+    len = sizeof(buffer);
+    if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, &producer) != SUCCESS ||
+        len != sizeof(pair) || producer != ids[1] || buffer[1] != 2) {
+        printf("Error: Test 2 failed. Message lost\n");
+        exit(1);
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * a deregistered ring is drained, then reused                           *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 3: register and deregister\n");
+    for (int p = 3; p < PRODUCERS; p++) {
+        ringbuffer_fanin_register(fanin, &ids[p]);
+    }
+    if (ringbuffer_fanin_register(fanin, &producer) != EAGAIN) {
+        printf("Error: Test 3 failed. Too many producers\n");
+        exit(1);
+    }
+    int last = 42;
+    ringbuffer_fanin_write(fanin, ids[0], &last, sizeof(last), RB_TIMEOUT_TRY);
+    ringbuffer_fanin_deregister(fanin, ids[0]);
+    if (ringbuffer_fanin_write(fanin, ids[0], &last, sizeof(last), RB_TIMEOUT_TRY) != EINVAL ||
+        ringbuffer_fanin_register(fanin, &producer) != EAGAIN) {
+        printf("Error: Test 3 failed. Closed ring reused before it was drained\n");
+        exit(1);
+    }
+    len = sizeof(buffer);
+    if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, &producer) != SUCCESS || buffer[0] != 42 ||
+        producer != ids[0]) {
+        printf("Error: Test 3 failed. Message of a deregistered producer lost\n");
+        exit(1);
+    }
+    len = sizeof(buffer);
+    if (ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, NULL) != RINGBUFFER_EMPTY ||
+        ringbuffer_fanin_register(fanin, &producer) != SUCCESS || producer != ids[0]) {
+        printf("Error: Test 3 failed. Drained ring not freed\n");
+        exit(1);
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * concurrent producers come and go while consumers read                 *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 4: concurrent producers and consumers\n");
+    ringbuffer_fanin_destroy(fanin);
+    ringbuffer_fanin_init(fanin, rbuf, RBUF_SIZE, PRODUCERS, NULL);
+    pthread_t producers[THREADS], consumers[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++) {
+        pthread_create(&consumers[i], NULL, consume, NULL);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&producers[i], NULL, produce, (void *)(intptr_t) i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        void *res;
+        pthread_join(producers[i], &res);
+        if (res != NULL) {
+            printf("Error: Test 4 failed. Producer %d could not write\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    // the last rings are freed by the next consumer that finds them empty
+    len = sizeof(buffer);
+    ringbuffer_fanin_read(fanin, buffer, &len, RB_TIMEOUT_TRY, NULL);
+    for (int p = 0; p < PRODUCERS; p++) {
+        if (ringbuffer_fanin_register(fanin, &ids[p]) != SUCCESS) {
+            printf("Error: Test 4 failed. Ring not freed after the run\n");
+            exit(1);
+        }
+    }
+    printf("  + Test 4 passed\n");
+
+    /*************************************************************************
+     * TEST 5:                                                               *
+     * consumers blocked without a timeout get every message                 *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 5: consumers blocked on infinite timeouts\n");
+    ringbuffer_fanin_destroy(fanin);
+    ringbuffer_fanin_init(fanin, rbuf, RBUF_SIZE, PRODUCERS, NULL);
+    pthread_t blocking[BLOCKING_CONSUMERS], writers[2];
+    for (int i = 0; i < BLOCKING_CONSUMERS; i++) {
+        pthread_create(&blocking[i], NULL, consume_blocking, NULL);
+    }
+    for (int i = 0; i < 2; i++) {
+        ringbuffer_fanin_register(fanin, &ids[i]);
+        pthread_create(&writers[i], NULL, produce_share, &ids[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        void *res;
+        pthread_join(writers[i], &res);
+        if (res != NULL) {
+            printf("Error: Test 5 failed. Producer %d could not write\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < BLOCKING_CONSUMERS; i++) {
+        void *res;
+        pthread_join(blocking[i], &res);
+        if (res != NULL) {
+            printf("Error: Test 5 failed. Consumer %d could not read\n", i);
+            exit(1);
+        }
+    }
+    printf("  + Test 5 passed\n");
+
+    ringbuffer_fanin_destroy(fanin);
+    free(fanin);
+    free(rbuf);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 256
+#define RECORD_SIZE 16
+
+/* fills the ring with record_len byte messages and returns how many fit */
+size_t fill(rbctx_t *ctx, size_t record_len) {
+    char msg[RECORD_SIZE] = {0};
+    size_t n = 0;
+    while (ringbuffer_write_timed(ctx, msg, record_len, RB_TIMEOUT_TRY) == SUCCESS) {
+        n++;
+    }
+    char buffer[RECORD_SIZE];
+    size_t buffer_len = sizeof(buffer);
+    while (ringbuffer_read_timed(ctx, buffer, &buffer_len, RB_TIMEOUT_TRY) == SUCCESS) {
+        buffer_len = sizeof(buffer);
+    }
+    return n;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[200];
+    for (size_t i = 0; i < sizeof(msg); i++) {
+        msg[i] = 'a' + i % 26;
+    }
+    char buffer[200];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.slot_size = RECORD_SIZE;
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC};
+    rbframing_t framings[] = {RB_FRAME_SIZE_T, RB_FRAME_U16, RB_FRAME_U32, RB_FRAME_VARINT};
+
+    for (int m = 0; m < 2; m++) {
+        attr.mode = modes[m];
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * messages of every size survive wrapping with every length header      *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: write/read with every length header\n", m + 1);
+        size_t sizes[] = {1, 5, 127, 128, 150, 3, 200, 77};
+        for (int f = 0; f < 4; f++) {
+            attr.framing = framings[f];
+            ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+            for (int round = 0; round < 5; round++) {
+                for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+                    size_t buffer_len = sizeof(buffer);
+                    if (ringbuffer_write(ringbuffer_context, msg, sizes[i]) != SUCCESS ||
+                        ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+                        buffer_len != sizes[i] || memcmp(buffer, msg, sizes[i]) != 0) {
+                        printf("Error: Test %d.1 failed. framing %d, message of %zu bytes\n", m + 1, f, sizes[i]);
+                        exit(1);
+                    }
+                }
+            }
+            ringbuffer_destroy(ringbuffer_context);
+        }
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * compact headers fit more messages into the same ring                  *
+         *************************************************************************/
+        printf("Test %d.2: capacity\n", m + 1);
+        size_t fits[5];
+        for (int f = 0; f < 5; f++) {
+            attr.framing = f < 4 ? framings[f] : RB_FRAME_FIXED;
+            ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+            fits[f] = fill(ringbuffer_context, RECORD_SIZE);
+            ringbuffer_destroy(ringbuffer_context);
+        }
+        // the locked ring keeps one byte free, SPSC cursors tell full from empty
+        size_t usable = attr.mode == RB_MODE_LOCKED ? RBUF_SIZE - 1 : RBUF_SIZE;
+        if (fits[0] != usable / (RECORD_SIZE + sizeof(size_t)) ||
+            fits[1] != usable / (RECORD_SIZE + 2) ||
+            fits[2] != usable / (RECORD_SIZE + 4) ||
+            fits[3] != usable / (RECORD_SIZE + 1) ||
+            fits[4] != usable / RECORD_SIZE) {
+            printf("Error: Test %d.2 failed. Unexpected capacity %zu %zu %zu %zu %zu\n",
+                   m + 1, fits[0], fits[1], fits[2], fits[3], fits[4]);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * fixed records are padded and longer messages are rejected             *
+         *************************************************************************/
+        printf("Test %d.3: fixed records and header limits\n", m + 1);
+        attr.framing = RB_FRAME_FIXED;
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        size_t buffer_len = sizeof(buffer);
+        memset(buffer, 'x', sizeof(buffer));
+        if (ringbuffer_write(ringbuffer_context, msg, 10) != SUCCESS ||
+            ringbuffer_write(ringbuffer_context, msg, RECORD_SIZE + 1) != RINGBUFFER_FULL ||
+            ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != RECORD_SIZE || memcmp(buffer, msg, 10) != 0 ||
+            buffer[10] != 0 || buffer[RECORD_SIZE - 1] != 0) {
+            printf("Error: Test %d.3 failed. Fixed record not padded\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+
+        char *big = malloc(70000);
+        char *big_rbuf = malloc(80000);
+        if (big == NULL || big_rbuf == NULL) {
+            printf("Error: malloc failed\n");
+            exit(1);
+        }
+        attr.framing = RB_FRAME_U16;
+        ringbuffer_init_attr(ringbuffer_context, big_rbuf, 80000, &attr);
+        if (ringbuffer_write(ringbuffer_context, big, 70000) != RINGBUFFER_FULL) {
+            printf("Error: Test %d.3 failed. u16 header accepted a 70000 byte message\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+        free(big);
+        free(big_rbuf);
+        printf("  + Test %d.3 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 4:                                                               *
+         * a varint reservation committed with less keeps its header width       *
+         *************************************************************************/
+        printf("Test %d.4: varint reserve/commit\n", m + 1);
+        attr.framing = RB_FRAME_VARINT;
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        for (int i = 0; i < 10; i++) {
+            rbspan_t span;
+            if (ringbuffer_write_reserve(ringbuffer_context, 150, &span) != SUCCESS) {
+                printf("Error: Test %d.4 failed. Reserve failed\n", m + 1);
+                exit(1);
+            }
+            ringbuffer_span_write(&span, 0, msg, 5);
+            ringbuffer_write_commit(ringbuffer_context, &span, 5);
+            if (ringbuffer_read_peek(ringbuffer_context, &span) != SUCCESS ||
+                span.len[0] + span.len[1] != 5 ||
+                ringbuffer_span_read(&span, 0, buffer, 5) != 5 || memcmp(buffer, msg, 5) != 0) {
+                printf("Error: Test %d.4 failed. Committed message does not match\n", m + 1);
+                exit(1);
+            }
+            ringbuffer_read_release(ringbuffer_context, &span);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+        printf("  + Test %d.4 passed\n", m + 1);
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 1024
+#define MSG_LEN 32
+#define RESIDENCY_US 2000          // 2 ms
+#define SHORT_TIMEOUT 5000000      // 5 ms
+
+/* checks that the percentiles of one histogram are ordered and fall into [low, high] */
+int check_summary(const rbhist_summary_t *h, uint64_t count, uint64_t low, uint64_t high) {
+    return h->count == count && h->p50 >= low && h->p50 <= h->p99 && h->p99 <= h->p999 &&
+           h->p999 <= h->max && h->max <= high;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[MSG_LEN] = "histogram";
+    char buffer[MSG_LEN];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    rbhist_summary_t h;
+    int res = ringbuffer_get_histogram(ringbuffer_context, RB_HIST_WAIT, &h);
+    if (ringbuffer_get_histogram(ringbuffer_context, RB_HIST_KINDS, &h) != EINVAL) {
+        printf("Error: unknown histogram accepted\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    if (res == ENOTSUP) {
+        printf("Histograms not compiled in (build with HISTOGRAMS=1)\n");
+        free(rbuf);
+        free(ringbuffer_context);
+        printf("All tests passed\n");
+        return 0;
+    }
+
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+    for (int m = 0; m < 3; m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * residency covers the time between write and read                      *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: residency\n", m + 1);
+        for (int i = 0; i < 3; i++) {
+            size_t buffer_len = sizeof(buffer);
+            ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+            usleep(RESIDENCY_US);
+            if (i == 2) {
+                // zero-copy reads are timed at release
+                rbspan_t span;
+                ringbuffer_read_peek(ringbuffer_context, &span);
+                ringbuffer_read_release(ringbuffer_context, &span);
+            } else {
+                ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+            }
+        }
+        ringbuffer_get_histogram(ringbuffer_context, RB_HIST_RESIDENCY, &h);
+        if (!check_summary(&h, 3, RESIDENCY_US * 1000, RB_TIMEOUT_DEFAULT)) {
+            printf("Error: Test %d.1 failed. n=%llu p50 %llu max %llu\n", m + 1,
+                   (unsigned long long) h.count, (unsigned long long) h.p50, (unsigned long long) h.max);
+            exit(1);
+        }
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * waits are recorded, calls that do not wait are not                    *
+         *************************************************************************/
+        printf("Test %d.2: wait\n", m + 1);
+        size_t buffer_len = sizeof(buffer);
+        ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY);
+        ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, SHORT_TIMEOUT);
+        ringbuffer_get_histogram(ringbuffer_context, RB_HIST_WAIT, &h);
+        if (!check_summary(&h, 1, SHORT_TIMEOUT, RB_TIMEOUT_DEFAULT)) {
+            printf("Error: Test %d.2 failed. n=%llu p50 %llu max %llu\n", m + 1,
+                   (unsigned long long) h.count, (unsigned long long) h.p50, (unsigned long long) h.max);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * lock hold times are only kept by the locked ring                      *
+         *************************************************************************/
+        printf("Test %d.3: lock hold\n", m + 1);
+        ringbuffer_get_histogram(ringbuffer_context, RB_HIST_LOCK_HOLD, &h);
+        // three writes, two reads and a peek/release in the locked ring
+        uint64_t holds = attr.mode == RB_MODE_LOCKED ? 6 : 0;
+        if (!check_summary(&h, holds, 0, RB_TIMEOUT_DEFAULT)) {
+            printf("Error: Test %d.3 failed. n=%llu\n", m + 1, (unsigned long long) h.count);
+            exit(1);
+        }
+        printf("  + Test %d.3 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 4:                                                               *
+         * reset empties every histogram                                         *
+         *************************************************************************/
+        printf("Test %d.4: reset\n", m + 1);
+        ringbuffer_reset_histograms(ringbuffer_context);
+        for (int kind = 0; kind < RB_HIST_KINDS; kind++) {
+            ringbuffer_get_histogram(ringbuffer_context, (rbhist_kind_t) kind, &h);
+            if (h.count != 0 || h.max != 0) {
+                printf("Error: Test %d.4 failed. Histogram %d not cleared\n", m + 1, kind);
+                exit(1);
+            }
+        }
+        printf("  + Test %d.4 passed\n", m + 1);
+
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
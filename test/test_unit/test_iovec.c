@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+typedef struct {
+    size_t from;
+    size_t to;
+    size_t packet_id;
+} header_t;
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    char payload[] = "payload that follows the header";
+    size_t msg_len = sizeof(header_t) + sizeof(payload);
+    size_t rbuf_size = 2 * (msg_len + sizeof(size_t)) - 20; // second message wraps
+    char* rbuf = malloc(rbuf_size);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.slot_size = 128;
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+
+    for (int m = 0; m < 3; m++) {
+        if (modes[m] == RB_MODE_MPMC) {
+            free(rbuf);
+            rbuf_size = 512;
+            rbuf = malloc(rbuf_size);
+            if (rbuf == NULL) {
+                printf("Error: malloc failed\n");
+                exit(1);
+            }
+        }
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, rbuf_size, &attr);
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * gather a header and a payload, scatter them into a struct and buffer  *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: writev/readv\n", m + 1);
+
+        for (size_t id = 0; id < 4; id++) {
+            header_t header = {1, 2, id};
+            struct iovec w_iov[3] = {
+                {&header, sizeof(header)},
+                {payload, 10},
+                {payload + 10, sizeof(payload) - 10}
+            };
+            if (ringbuffer_writev(ringbuffer_context, w_iov, 3) != SUCCESS) {
+                printf("Error: Test %d.1 failed. writev failed\n", m + 1);
+                exit(1);
+            }
+
+            header_t read_header;
+            char read_payload[64];
+            struct iovec r_iov[2] = {
+                {&read_header, sizeof(read_header)},
+                {read_payload, sizeof(read_payload)}
+            };
+            size_t read_len;
+            if (ringbuffer_readv(ringbuffer_context, r_iov, 2, &read_len) != SUCCESS || read_len != msg_len) {
+                printf("Error: Test %d.1 failed. readv failed\n", m + 1);
+                exit(1);
+            }
+            if (read_header.from != 1 || read_header.to != 2 || read_header.packet_id != id ||
+                strcmp(read_payload, payload) != 0) {
+                printf("Error: Test %d.1 failed. Message does not match\n", m + 1);
+                exit(1);
+            }
+        }
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * buffers that are too small leave the message in the ring              *
+         *************************************************************************/
+        printf("Test %d.2: readv into too small buffers\n", m + 1);
+        struct iovec w_iov[1] = {{payload, sizeof(payload)}};
+        if (ringbuffer_writev(ringbuffer_context, w_iov, 1) != SUCCESS) {
+            printf("Error: Test %d.2 failed. writev failed\n", m + 1);
+            exit(1);
+        }
+        char small[2][8];
+        struct iovec r_iov[2] = {{small[0], 8}, {small[1], 8}};
+        size_t read_len;
+        if (ringbuffer_readv(ringbuffer_context, r_iov, 2, &read_len) != OUTPUT_BUFFER_TOO_SMALL) {
+            printf("Error: Test %d.2 failed. Expected OUTPUT_BUFFER_TOO_SMALL\n", m + 1);
+            exit(1);
+        }
+        char buffer[64];
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS || strcmp(buffer, payload) != 0) {
+            printf("Error: Test %d.2 failed. Message was lost\n", m + 1);
+            exit(1);
+        }
+        if (ringbuffer_readv_timed(ringbuffer_context, r_iov, 2, &read_len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY) {
+            printf("Error: Test %d.2 failed. Expected RINGBUFFER_EMPTY without waiting\n", m + 1);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
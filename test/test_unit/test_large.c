@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../include/ringbuf_arena.h"
+
+#define RBUF_SIZE 256
+#define BLOCK_SIZE 65536
+#define BLOCKS 4
+#define THRESHOLD 64
+#define ARENA_SIZE (BLOCKS * (BLOCK_SIZE + sizeof(uint32_t)) + RB_CACHE_LINE)
+#define NUMBER_OF_MESSAGES 2000
+
+rbctx_t ringbuffer_context;
+rbarena_t arena;
+
+/* message i: i bytes long (mod BLOCK_SIZE), every byte derived from i and its offset */
+size_t make_msg(unsigned char *msg, int i) {
+    size_t len = (size_t)(i * 7919) % BLOCK_SIZE;
+    for (size_t j = 0; j < len; j++) {
+        msg[j] = (unsigned char)(i + j * 13);
+    }
+    return len;
+}
+
+int check_msg(const unsigned char *msg, size_t len, int i) {
+    static unsigned char expected[BLOCK_SIZE];
+    size_t expected_len = make_msg(expected, i);
+    return len == expected_len && memcmp(msg, expected, len) == 0;
+}
+
+void *produce(void *arg) {
+    (void) arg;
+    unsigned char *msg = malloc(BLOCK_SIZE);
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        size_t len = make_msg(msg, i);
+        ringbuffer_write_large(&ringbuffer_context, &arena, msg, len, RB_TIMEOUT_INFINITE);
+    }
+    free(msg);
+    return NULL;
+}
+
+int main() {
+    char *rbuf = malloc(RBUF_SIZE);
+    void *memory = malloc(ARENA_SIZE);
+    unsigned char *msg = malloc(BLOCK_SIZE);
+    unsigned char *buffer = malloc(BLOCK_SIZE);
+    if (rbuf == NULL || memory == NULL || msg == NULL || buffer == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    size_t len;
+
+    if (ringbuffer_arena_init(&arena, memory, ARENA_SIZE, BLOCK_SIZE, THRESHOLD) != SUCCESS ||
+        ringbuffer_arena_free_blocks(&arena) != BLOCKS || (uintptr_t) arena.blocks % RB_CACHE_LINE != 0) {
+        printf("Error: arena init failed\n");
+        exit(1);
+    }
+    ringbuffer_init(&ringbuffer_context, rbuf, RBUF_SIZE);
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * messages far larger than the ring pass through the arena              *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: small and large messages\n");
+    size_t lengths[] = {10, 50000, 0, THRESHOLD, THRESHOLD + 1, BLOCK_SIZE};
+    for (int i = 0; i < 6; i++) {
+        memset(msg, i + 1, lengths[i]);
+        len = BLOCK_SIZE;
+        if (ringbuffer_write_large(&ringbuffer_context, &arena, msg, lengths[i], RB_TIMEOUT_TRY) != SUCCESS ||
+            ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY) != SUCCESS ||
+            len != lengths[i] || memcmp(msg, buffer, len) != 0) {
+            printf("Error: Test 1 failed. Message of %zu bytes\n", lengths[i]);
+            exit(1);
+        }
+    }
+    if (ringbuffer_arena_free_blocks(&arena) != BLOCKS || arena.large_messages != 3) {
+        printf("Error: Test 1 failed. Blocks not recycled\n");
+        exit(1);
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * an exhausted arena fails like a full ring until a block is read       *
+     *************************************************************************/
+    printf("Test 2: exhausted arena\n");
+    for (int i = 0; i < BLOCKS; i++) {
+        ringbuffer_write_large(&ringbuffer_context, &arena, msg, 1000, RB_TIMEOUT_TRY);
+    }
+    if (ringbuffer_write_large(&ringbuffer_context, &arena, msg, 1000, RB_TIMEOUT_TRY) != RINGBUFFER_FULL ||
+        ringbuffer_write_large(&ringbuffer_context, &arena, msg, 1000, 10000000) != RINGBUFFER_FULL ||
+        arena.exhausted < 2) {
+        printf("Error: Test 2 failed. Wrote without a free block\n");
+        exit(1);
+    }
+    len = BLOCK_SIZE;
+    ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY);
+    if (ringbuffer_write_large(&ringbuffer_context, &arena, msg, 1000, RB_TIMEOUT_TRY) != SUCCESS ||
+        ringbuffer_write_large(&ringbuffer_context, &arena, msg, BLOCK_SIZE + 1, RB_TIMEOUT_TRY) != RINGBUFFER_FULL) {
+        printf("Error: Test 2 failed. Block not recycled or oversized message accepted\n");
+        exit(1);
+    }
+    for (int i = 0; i < BLOCKS; i++) {
+        len = BLOCK_SIZE;
+        ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY);
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * a too small buffer leaves the message, unsupported rings are refused  *
+     *************************************************************************/
+    printf("Test 3: small buffers and unsupported rings\n");
+    ringbuffer_write_large(&ringbuffer_context, &arena, msg, 5000, RB_TIMEOUT_TRY);
+    ringbuffer_write_large(&ringbuffer_context, &arena, msg, 50, RB_TIMEOUT_TRY);
+    len = 100;
+    if (ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY) != OUTPUT_BUFFER_TOO_SMALL) {
+        printf("Error: Test 3 failed. Large message read into a small buffer\n");
+        exit(1);
+    }
+    len = 5000;
+    ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY);
+    len = 10;
+    if (ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY) != OUTPUT_BUFFER_TOO_SMALL) {
+        printf("Error: Test 3 failed. Inline message read into a small buffer\n");
+        exit(1);
+    }
+    len = 50;
+    if (ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_TRY) != SUCCESS || len != 50 ||
+        ringbuffer_arena_free_blocks(&arena) != BLOCKS) {
+        printf("Error: Test 3 failed. Messages lost\n");
+        exit(1);
+    }
+    ringbuffer_destroy(&ringbuffer_context);
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.mode = RB_MODE_MPMC;
+    ringbuffer_init_attr(&ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    if (ringbuffer_write_large(&ringbuffer_context, &arena, msg, 10, RB_TIMEOUT_TRY) != ENOTSUP) {
+        printf("Error: Test 3 failed. MPMC ring accepted\n");
+        exit(1);
+    }
+    ringbuffer_destroy(&ringbuffer_context);
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * mixed sizes between a producer and a consumer thread                  *
+     *************************************************************************/
+    printf("Test 4: concurrent producer and consumer\n");
+    rbmode_t modes[] = {RB_MODE_SPSC, RB_MODE_TWOLOCK};
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(&ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        pthread_t producer;
+        pthread_create(&producer, NULL, produce, NULL);
+        for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+            len = BLOCK_SIZE;
+            if (ringbuffer_read_large(&ringbuffer_context, &arena, buffer, &len, RB_TIMEOUT_INFINITE) != SUCCESS ||
+                !check_msg(buffer, len, i)) {
+                printf("Error: Test 4 failed. Message %d lost or corrupted in mode %d\n", i, modes[m]);
+                exit(1);
+            }
+        }
+        pthread_join(producer, NULL);
+        if (ringbuffer_arena_free_blocks(&arena) != BLOCKS) {
+            printf("Error: Test 4 failed. Blocks leaked in mode %d\n", modes[m]);
+            exit(1);
+        }
+        ringbuffer_destroy(&ringbuffer_context);
+    }
+    printf("  + Test 4 passed\n");
+
+    ringbuffer_arena_destroy(&arena);
+    free(buffer);
+    free(msg);
+    free(memory);
+    free(rbuf);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
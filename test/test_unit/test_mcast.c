@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../include/ringbuf_mcast.h"
+
+#define RBUF_SIZE 1024
+#define MSG_LEN 24
+#define WRITERS 2
+#define CONSUMERS 3
+#define NUMBER_OF_MESSAGES 50000 // per writer
+
+rbmcast_t mc;
+unsigned ids[CONSUMERS];
+
+/* message: writer and number, followed by a pattern derived from both */
+void make_msg(unsigned char *msg, int writer, int i) {
+    memcpy(msg, &writer, sizeof(writer));
+    memcpy(msg + sizeof(writer), &i, sizeof(i));
+    for (size_t j = sizeof(writer) + sizeof(i); j < MSG_LEN; j++) {
+        msg[j] = (unsigned char)(writer * 31 + i + j);
+    }
+}
+
+void *produce(void *arg) {
+    int writer = (int)(intptr_t) arg;
+    unsigned char msg[MSG_LEN];
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        make_msg(msg, writer, i);
+        ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_INFINITE);
+    }
+    return NULL;
+}
+
+/* every consumer must see every message of every writer, in the order it was written */
+void *consume(void *arg) {
+    unsigned id = *(unsigned *) arg;
+    int next[WRITERS] = {0};
+    unsigned char msg[MSG_LEN], expected[MSG_LEN];
+    for (int n = 0; n < WRITERS * NUMBER_OF_MESSAGES; n++) {
+        size_t len = sizeof(msg);
+        if (ringbuffer_mcast_read(&mc, id, msg, &len, RB_TIMEOUT_INFINITE) != SUCCESS || len != MSG_LEN) {
+            return (void *) 1;
+        }
+        int writer;
+        memcpy(&writer, msg, sizeof(writer));
+        make_msg(expected, writer, next[writer]++);
+        if (writer < 0 || writer >= WRITERS || memcmp(msg, expected, MSG_LEN) != 0) {
+            return (void *) 1;
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    char *rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    unsigned char msg[MSG_LEN];
+    unsigned char buffer[MSG_LEN];
+    size_t len;
+    const size_t frame = sizeof(size_t) + MSG_LEN;
+
+    ringbuffer_mcast_init(&mc, rbuf, RBUF_SIZE);
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * every consumer reads every message                                    *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: all consumers see all messages\n");
+    unsigned a, b;
+    ringbuffer_mcast_subscribe(&mc, &a);
+    ringbuffer_mcast_subscribe(&mc, &b);
+    for (int i = 0; i < 10; i++) {
+        make_msg(msg, 0, i);
+        ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_TRY);
+    }
+    unsigned consumers[2] = {a, b};
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < 10; i++) {
+            make_msg(msg, 0, i);
+            len = sizeof(buffer);
+            if (ringbuffer_mcast_read(&mc, consumers[c], buffer, &len, RB_TIMEOUT_TRY) != SUCCESS ||
+                len != MSG_LEN || memcmp(msg, buffer, MSG_LEN) != 0) {
+                printf("Error: Test 1 failed. Consumer %u lost message %d\n", consumers[c], i);
+                exit(1);
+            }
+        }
+        len = sizeof(buffer);
+        if (ringbuffer_mcast_read(&mc, consumers[c], buffer, &len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY ||
+            ringbuffer_mcast_lag(&mc, consumers[c]) != 0) {
+            printf("Error: Test 1 failed. Consumer %u read too much\n", consumers[c]);
+            exit(1);
+        }
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * writers are held back by the slowest consumer only                    *
+     *************************************************************************/
+    printf("Test 2: slowest consumer gates writers\n");
+    int written = 0;
+    make_msg(msg, 0, 0);
+    while (ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_TRY) == SUCCESS) {
+        written++;
+    }
+    if ((size_t) written != RBUF_SIZE / frame || ringbuffer_mcast_lag(&mc, b) != written * frame) {
+        printf("Error: Test 2 failed. %d messages fit\n", written);
+        exit(1);
+    }
+    for (int i = 0; i < written; i++) {
+        len = sizeof(buffer);
+        ringbuffer_mcast_read(&mc, a, buffer, &len, RB_TIMEOUT_TRY);
+    }
+    if (ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_TRY) != RINGBUFFER_FULL) {
+        printf("Error: Test 2 failed. Writer overtook consumer %u\n", b);
+        exit(1);
+    }
+    len = sizeof(buffer);
+    ringbuffer_mcast_read(&mc, b, buffer, &len, RB_TIMEOUT_TRY);
+    if (ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_TRY) != SUCCESS) {
+        printf("Error: Test 2 failed. Writer not released\n");
+        exit(1);
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * consumers come and go at runtime                                      *
+     *************************************************************************/
+    printf("Test 3: subscribe and unsubscribe\n");
+    unsigned c;
+    ringbuffer_mcast_subscribe(&mc, &c);
+    len = sizeof(buffer);
+    if (ringbuffer_mcast_read(&mc, c, buffer, &len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY) {
+        printf("Error: Test 3 failed. New consumer saw old messages\n");
+        exit(1);
+    }
+    ringbuffer_mcast_unsubscribe(&mc, b); // b held back every writer
+    len = sizeof(buffer);
+    if (ringbuffer_mcast_write(&mc, msg, MSG_LEN, RB_TIMEOUT_TRY) != SUCCESS ||
+        ringbuffer_mcast_read(&mc, c, buffer, &len, RB_TIMEOUT_TRY) != SUCCESS) {
+        printf("Error: Test 3 failed. Unsubscribed consumer still gates writers\n");
+        exit(1);
+    }
+    ringbuffer_mcast_unsubscribe(&mc, a);
+    ringbuffer_mcast_unsubscribe(&mc, c);
+    len = sizeof(buffer);
+    if (ringbuffer_mcast_read(&mc, c, buffer, &len, RB_TIMEOUT_TRY) != EINVAL ||
+        ringbuffer_mcast_read(&mc, RB_MCAST_MAX_CONSUMERS - 1, buffer, &len, RB_TIMEOUT_TRY) != EINVAL) {
+        printf("Error: Test 3 failed. Read without a subscription\n");
+        exit(1);
+    }
+    unsigned all[RB_MCAST_MAX_CONSUMERS], extra;
+    for (int i = 0; i < RB_MCAST_MAX_CONSUMERS; i++) {
+        ringbuffer_mcast_subscribe(&mc, &all[i]);
+    }
+    if (ringbuffer_mcast_subscribe(&mc, &extra) != EAGAIN) {
+        printf("Error: Test 3 failed. Too many consumers\n");
+        exit(1);
+    }
+    for (int i = 0; i < RB_MCAST_MAX_CONSUMERS; i++) {
+        ringbuffer_mcast_unsubscribe(&mc, all[i]);
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * several writers, several consumers, concurrently                      *
+     *************************************************************************/
+    printf("Test 4: concurrent writers and consumers\n");
+    ringbuffer_mcast_destroy(&mc);
+    ringbuffer_mcast_init(&mc, rbuf, RBUF_SIZE);
+    pthread_t writers[WRITERS], readers[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++) {
+        ringbuffer_mcast_subscribe(&mc, &ids[i]);
+        pthread_create(&readers[i], NULL, consume, &ids[i]);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_create(&writers[i], NULL, produce, (void *)(intptr_t) i);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    for (int i = 0; i < CONSUMERS; i++) {
+        void *res;
+        pthread_join(readers[i], &res);
+        if (res != NULL) {
+            printf("Error: Test 4 failed. Consumer %d lost or reordered messages\n", i);
+            exit(1);
+        }
+    }
+    printf("  + Test 4 passed\n");
+
+    ringbuffer_mcast_destroy(&mc);
+    free(rbuf);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../include/ringbuf.h"
+
+#define MSG_LEN 1000 // does not divide the page size, so frames keep straddling the end
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    char msg[MSG_LEN];
+    char buffer[MSG_LEN];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC};
+
+    for (int m = 0; m < 2; m++) {
+        attr.mode = modes[m];
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * the size is rounded up to pages and both mappings alias each other    *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: mirrored mapping\n", m + 1);
+        if (ringbuffer_init_mirrored(ringbuffer_context, 100, &attr) != SUCCESS) {
+            printf("Error: Test %d.1 failed. ringbuffer_init_mirrored failed\n", m + 1);
+            exit(1);
+        }
+        size_t size = ringbuffer_context->end - ringbuffer_context->begin;
+        if (size != page || ringbuffer_context->storage != RB_STORAGE_MIRRORED) {
+            printf("Error: Test %d.1 failed. Expected one page, got %zu bytes\n", m + 1, size);
+            exit(1);
+        }
+        ringbuffer_context->begin[5] = 'x';
+        if (ringbuffer_context->end[5] != 'x') {
+            printf("Error: Test %d.1 failed. Second mapping does not alias the first\n", m + 1);
+            exit(1);
+        }
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * every reserved and peeked span is contiguous, also across the end     *
+         *************************************************************************/
+        printf("Test %d.2: contiguous spans\n", m + 1);
+        for (int i = 0; i < 50; i++) {
+            memset(msg, 'a' + i % 26, sizeof(msg));
+            rbspan_t span;
+            if (ringbuffer_write_reserve(ringbuffer_context, MSG_LEN, &span) != SUCCESS ||
+                span.ptr[1] != NULL || span.len[0] != MSG_LEN) {
+                printf("Error: Test %d.2 failed. Reservation %d not contiguous\n", m + 1, i);
+                exit(1);
+            }
+            memcpy(span.ptr[0], msg, MSG_LEN);
+            ringbuffer_write_commit(ringbuffer_context, &span, MSG_LEN);
+
+            if (ringbuffer_read_peek(ringbuffer_context, &span) != SUCCESS ||
+                span.ptr[1] != NULL || span.len[0] != MSG_LEN ||
+                memcmp(span.ptr[0], msg, MSG_LEN) != 0) {
+                printf("Error: Test %d.2 failed. Peeked message %d does not match\n", m + 1, i);
+                exit(1);
+            }
+            ringbuffer_read_release(ringbuffer_context, &span);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * plain write/read keep working when prefixes and messages wrap         *
+         *************************************************************************/
+        printf("Test %d.3: write/read\n", m + 1);
+        for (int i = 0; i < 50; i++) {
+            memset(msg, 'A' + i % 26, sizeof(msg));
+            size_t len = MSG_LEN - i;
+            size_t buffer_len = sizeof(buffer);
+            if (ringbuffer_write(ringbuffer_context, msg, len) != SUCCESS ||
+                ringbuffer_write(ringbuffer_context, msg, len) != SUCCESS ||
+                ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+                buffer_len != len || memcmp(buffer, msg, len) != 0) {
+                printf("Error: Test %d.3 failed at message %d\n", m + 1, i);
+                exit(1);
+            }
+            buffer_len = sizeof(buffer);
+            if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+                buffer_len != len || memcmp(buffer, msg, len) != 0) {
+                printf("Error: Test %d.3 failed at message %d\n", m + 1, i);
+                exit(1);
+            }
+        }
+        printf("  + Test %d.3 passed\n", m + 1);
+
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
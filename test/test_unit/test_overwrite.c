@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 256
+#define NUMBER_OF_MESSAGES 1000
+#define MAX_WRITE_NS 100000000 // 100 ms for all writes into a full ring
+
+/* message i is i repeated, 1 to 32 bytes long */
+size_t make_msg(unsigned char *msg, int i) {
+    size_t len = 1 + (i * 7) % 32;
+    memset(msg, i & 0xff, len);
+    return len;
+}
+
+int check_msg(const unsigned char *msg, size_t len, uint64_t seq, rbframing_t framing, size_t slot_size) {
+    unsigned char expected[32];
+    size_t expected_len = make_msg(expected, (int) seq);
+    if (framing == RB_FRAME_FIXED) {
+        return len == slot_size && memcmp(msg, expected, expected_len) == 0;
+    }
+    return len == expected_len && memcmp(msg, expected, len) == 0;
+}
+
+int64_t elapsed_ns(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) (now.tv_sec - since->tv_sec) * 1000000000 + (now.tv_nsec - since->tv_nsec);
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    unsigned char msg[64];
+    unsigned char buffer[64];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.overwrite = 1;
+    attr.slot_size = 32;
+    rbframing_t framings[] = {RB_FRAME_SIZE_T, RB_FRAME_VARINT, RB_FRAME_FIXED};
+    for (int f = 0; f < 3; f++) {
+        attr.framing = framings[f];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * writes into a full ring drop the oldest messages and never wait       *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: writes never block\n", f + 1);
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+            size_t len = make_msg(msg, i);
+            if (ringbuffer_write(ringbuffer_context, msg, len) != SUCCESS) {
+                printf("Error: Test %d.1 failed. Write %d failed\n", f + 1, i);
+                exit(1);
+            }
+        }
+        if (elapsed_ns(&start) > MAX_WRITE_NS) {
+            printf("Error: Test %d.1 failed. Writes waited\n", f + 1);
+            exit(1);
+        }
+        printf("  + Test %d.1 passed\n", f + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * the newest messages survive whole, the gap matches the drop counter   *
+         *************************************************************************/
+        printf("Test %d.2: gap and drop counter\n", f + 1);
+        uint64_t seq, first = 0, n = 0;
+        size_t buffer_len = sizeof(buffer);
+        while (ringbuffer_read_seq(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY, &seq) == SUCCESS) {
+            if (n == 0) {
+                first = seq;
+            }
+            if (seq != first + n || !check_msg(buffer, buffer_len, seq, attr.framing, attr.slot_size)) {
+                printf("Error: Test %d.2 failed. Message %lu damaged or out of order\n", f + 1, (unsigned long) seq);
+                exit(1);
+            }
+            n++;
+            buffer_len = sizeof(buffer);
+        }
+        rbstats_t stats;
+        ringbuffer_get_stats(ringbuffer_context, &stats);
+        if (n == 0 || first + n != NUMBER_OF_MESSAGES || stats.dropped != first) {
+            printf("Error: Test %d.2 failed. first %lu, %lu read, %lu dropped\n", f + 1,
+                   (unsigned long) first, (unsigned long) n, (unsigned long) stats.dropped);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", f + 1);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * a message that can never fit fails without dropping anything          *
+         *************************************************************************/
+        printf("Test %d.3: message larger than the ring\n", f + 1);
+        ringbuffer_write(ringbuffer_context, msg, 1);
+        char big[RBUF_SIZE];
+        memset(big, 0, sizeof(big));
+        int res = ringbuffer_write(ringbuffer_context, big, sizeof(big));
+        ringbuffer_get_stats(ringbuffer_context, &stats);
+        if (res != RINGBUFFER_FULL || stats.dropped != first ||
+            ringbuffer_read_seq(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY, &seq) != SUCCESS ||
+            seq != NUMBER_OF_MESSAGES) {
+            printf("Error: Test %d.3 failed\n", f + 1);
+            exit(1);
+        }
+        printf("  + Test %d.3 passed\n", f + 1);
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * without overwrite the numbers have no gaps and full rings still fail  *
+     *************************************************************************/
+    printf("Test 4: lossless ring\n");
+    ringbuffer_attr_init(&attr);
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    int written = 0;
+    while (ringbuffer_write_timed(ringbuffer_context, msg, make_msg(msg, written), RB_TIMEOUT_TRY) == SUCCESS) {
+        written++;
+    }
+    for (int i = 0; i < written; i++) {
+        uint64_t seq;
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_read_seq(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY, &seq) != SUCCESS ||
+            seq != (uint64_t) i) {
+            printf("Error: Test 4 failed at message %d\n", i);
+            exit(1);
+        }
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    attr.mode = RB_MODE_SPSC;
+    attr.overwrite = 1;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+    uint64_t seq;
+    size_t buffer_len = sizeof(buffer);
+    if (ringbuffer_read_seq(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY, &seq) != ENOTSUP ||
+        ringbuffer_context->overwrite) {
+        printf("Error: Test 4 failed. Lock-free ring accepted overwrite\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 4 passed\n");
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
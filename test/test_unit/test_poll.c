@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 1024
+#define MSG_LEN 32
+#define BURST 5
+#define NUMBER_OF_MESSAGES 20000
+#define POLL_TIMEOUT_MS 2000
+
+/* whether fd polls readable within timeout_ms */
+int readable(int fd, int timeout_ms) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN);
+}
+
+/* value the fd was signaled with since it was last drained */
+uint64_t pending(int fd) {
+    uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+rbctx_t *rings[2];
+
+void *produce(void *arg) {
+    (void) arg;
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        ringbuffer_write_timed(rings[i % 2], &i, sizeof(i), RB_TIMEOUT_INFINITE);
+        if (i % 1000 == 0) {
+            usleep(1000); // let the consumer go back to poll now and then
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    rbctx_t *other = malloc(sizeof(rbctx_t));
+    char *rbuf = malloc(RBUF_SIZE);
+    char *other_rbuf = malloc(RBUF_SIZE);
+    if (ringbuffer_context == NULL || other == NULL || rbuf == NULL || other_rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[MSG_LEN] = "poll me";
+    char buffer[MSG_LEN];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+    for (int m = 0; m < 3; m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        if (ringbuffer_data_fd(ringbuffer_context) != -1 || ringbuffer_enable_poll(ringbuffer_context) != SUCCESS) {
+            printf("Error: could not enable poll\n");
+            exit(1);
+        }
+        int data_fd = ringbuffer_data_fd(ringbuffer_context);
+        int space_fd = ringbuffer_space_fd(ringbuffer_context);
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * the data fd turns readable once per burst and is drained by arming    *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: data fd\n", m + 1);
+        if (readable(data_fd, 0)) {
+            printf("Error: Test %d.1 failed. Empty ring is readable\n", m + 1);
+            exit(1);
+        }
+        for (int i = 0; i < BURST; i++) {
+            ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+        }
+        if (!readable(data_fd, 0) || pending(data_fd) != 1) {
+            printf("Error: Test %d.1 failed. Burst not signaled exactly once\n", m + 1);
+            exit(1);
+        }
+        size_t buffer_len = sizeof(buffer);
+        int n = 0;
+        while (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY) == SUCCESS) {
+            n++;
+        }
+        // not armed while the burst was drained, so nothing new is pending
+        if (n != BURST || readable(data_fd, 0)) {
+            printf("Error: Test %d.1 failed. read %d messages\n", m + 1, n);
+            exit(1);
+        }
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+        if (!readable(data_fd, 0)) {
+            printf("Error: Test %d.1 failed. Empty read did not arm the fd\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * the space fd turns readable after a full ring is read from            *
+         *************************************************************************/
+        printf("Test %d.2: space fd\n", m + 1);
+        while (ringbuffer_write_timed(ringbuffer_context, msg, MSG_LEN, RB_TIMEOUT_TRY) == SUCCESS);
+        if (readable(space_fd, 0)) {
+            printf("Error: Test %d.2 failed. Full ring is writable\n", m + 1);
+            exit(1);
+        }
+        buffer_len = sizeof(buffer);
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        if (!readable(space_fd, 0) || pending(space_fd) != 1) {
+            printf("Error: Test %d.2 failed. Freed space not signaled\n", m + 1);
+            exit(1);
+        }
+        // every full write arms it again
+        while (ringbuffer_write_timed(ringbuffer_context, msg, MSG_LEN, RB_TIMEOUT_TRY) == SUCCESS);
+        struct iovec iov = {msg, MSG_LEN};
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        if (!readable(space_fd, 0) || ringbuffer_writev(ringbuffer_context, &iov, 1) != SUCCESS) {
+            printf("Error: Test %d.2 failed. writev did not fit\n", m + 1);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+        ringbuffer_destroy(ringbuffer_context);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * one consumer polls two rings fed by another thread                    *
+         *************************************************************************/
+        printf("Test %d.3: poll two rings\n", m + 1);
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        ringbuffer_init_attr(other, other_rbuf, RBUF_SIZE, &attr);
+        rings[0] = ringbuffer_context;
+        rings[1] = other;
+        ringbuffer_enable_poll(rings[0]);
+        ringbuffer_enable_poll(rings[1]);
+        pthread_t producer;
+        pthread_create(&producer, NULL, produce, NULL);
+        int expected[2] = {0, 1};
+        int received = 0;
+        while (received < NUMBER_OF_MESSAGES) {
+            struct pollfd pfds[2] = {{ringbuffer_data_fd(rings[0]), POLLIN, 0},
+                                     {ringbuffer_data_fd(rings[1]), POLLIN, 0}};
+            if (poll(pfds, 2, POLL_TIMEOUT_MS) <= 0) {
+                printf("Error: Test %d.3 failed. No wakeup after %d messages\n", m + 1, received);
+                exit(1);
+            }
+            for (int r = 0; r < 2; r++) {
+                int value;
+                size_t len = sizeof(value);
+                while (ringbuffer_read_timed(rings[r], &value, &len, RB_TIMEOUT_TRY) == SUCCESS) {
+                    if (value != expected[r]) {
+                        printf("Error: Test %d.3 failed. Expected %d, got %d\n", m + 1, expected[r], value);
+                        exit(1);
+                    }
+                    expected[r] += 2;
+                    received++;
+                }
+            }
+        }
+        pthread_join(producer, NULL);
+        ringbuffer_destroy(rings[0]);
+        ringbuffer_destroy(rings[1]);
+        printf("  + Test %d.3 passed\n", m + 1);
+    }
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * eventfds are per process, shared rings cannot have them              *
+     *************************************************************************/
+    printf("Test 4: shared ring\n");
+    char name[64];
+    snprintf(name, sizeof(name), "/ringbuf-poll-%ld", (long) getpid());
+    ringbuffer_unlink_shared(name);
+    if (ringbuffer_create_shared(ringbuffer_context, name, RBUF_SIZE, NULL) != SUCCESS ||
+        ringbuffer_enable_poll(ringbuffer_context) != EINVAL || ringbuffer_data_fd(ringbuffer_context) != -1) {
+        printf("Error: Test 4 failed\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    ringbuffer_unlink_shared(name);
+    printf("  + Test 4 passed\n");
+
+    free(rbuf);
+    free(other_rbuf);
+    free(ringbuffer_context);
+    free(other);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../include/ringbuf_prio.h"
+
+#define RBUF_SIZE 4096
+#define LANES 3
+#define PER_LANE 8
+#define SHORT_TIMEOUT 20000000 // 20 ms
+
+rbprio_t prio;
+
+void *write_later(void *arg) {
+    (void) arg;
+    usleep(20000);
+    int value = 42;
+    ringbuffer_prio_write(&prio, 2, &value, sizeof(value), RB_TIMEOUT_DEFAULT);
+    return NULL;
+}
+
+int main() {
+    char *rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    rbprio_attr_t attr;
+    ringbuffer_prio_attr_init(&attr);
+    attr.lanes = LANES;
+    if (ringbuffer_prio_init(&prio, rbuf, RBUF_SIZE, &attr) != SUCCESS) {
+        printf("Error: init failed\n");
+        exit(1);
+    }
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * strict priority: higher lanes first, FIFO inside a lane               *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: strict priority\n");
+    // bulk traffic first, control traffic last
+    for (int i = 0; i < PER_LANE; i++) {
+        for (int lane = LANES - 1; lane >= 0; lane--) {
+            int value = lane * 100 + i;
+            ringbuffer_prio_write(&prio, lane, &value, sizeof(value), RB_TIMEOUT_TRY);
+        }
+    }
+    rbprio_stats_t stats;
+    ringbuffer_prio_get_stats(&prio, &stats);
+    for (int lane = 0; lane < LANES; lane++) {
+        if (stats.queued_bytes[lane] != PER_LANE * (sizeof(size_t) + sizeof(int)) ||
+            stats.lane[lane].messages_written != PER_LANE) {
+            printf("Error: Test 1 failed. Lane %d has %lu bytes queued\n", lane, (unsigned long) stats.queued_bytes[lane]);
+            exit(1);
+        }
+    }
+    ringbuffer_reset_stats(&prio.lane[0]); // the counters no longer know about the queued messages
+    ringbuffer_prio_get_stats(&prio, &stats);
+    if (stats.queued_bytes[0] != PER_LANE * (sizeof(size_t) + sizeof(int))) {
+        printf("Error: Test 1 failed. Queued bytes follow the reset counters\n");
+        exit(1);
+    }
+    for (int lane = 0; lane < LANES; lane++) {
+        for (int i = 0; i < PER_LANE; i++) {
+            int value;
+            size_t len = sizeof(value);
+            unsigned priority;
+            if (ringbuffer_prio_read(&prio, &value, &len, RB_TIMEOUT_TRY, &priority) != SUCCESS ||
+                priority != (unsigned) lane || value != lane * 100 + i) {
+                printf("Error: Test 1 failed. Expected %d, got %d from lane %u\n", lane * 100 + i, value, priority);
+                exit(1);
+            }
+        }
+    }
+    ringbuffer_prio_get_stats(&prio, &stats);
+    if (stats.queued_bytes[0] != 0 || stats.queued_bytes[LANES - 1] != 0) {
+        printf("Error: Test 1 failed. Lanes not drained\n");
+        exit(1);
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * weighted round-robin: lane i delivers weights[i] messages per round   *
+     *************************************************************************/
+    printf("Test 2: weighted round-robin\n");
+    ringbuffer_prio_destroy(&prio);
+    attr.policy = RB_PRIO_WEIGHTED;
+    attr.weights[0] = 3;
+    attr.weights[1] = 1;
+    attr.weights[2] = 2;
+    ringbuffer_prio_init(&prio, rbuf, RBUF_SIZE, &attr);
+    for (int lane = 0; lane < LANES; lane++) {
+        for (int i = 0; i < PER_LANE; i++) {
+            ringbuffer_prio_write(&prio, lane, &i, sizeof(i), RB_TIMEOUT_TRY);
+        }
+    }
+    // lane 0 runs empty in the third round, lane 2 in the fourth, then lane 1 gets every turn
+    const char *expected = "000122" "000122" "00122" "122" "1111";
+    for (size_t n = 0; n < strlen(expected); n++) {
+        int value;
+        size_t len = sizeof(value);
+        unsigned priority;
+        if (ringbuffer_prio_read(&prio, &value, &len, RB_TIMEOUT_TRY, &priority) != SUCCESS ||
+            priority != (unsigned) (expected[n] - '0')) {
+            printf("Error: Test 2 failed. Message %zu came from lane %u, expected %c\n", n, priority, expected[n]);
+            exit(1);
+        }
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * readers wait for any lane, unknown priorities are rejected            *
+     *************************************************************************/
+    printf("Test 3: waiting and errors\n");
+    int value;
+    size_t len = sizeof(value);
+    while (ringbuffer_prio_read(&prio, &value, &len, RB_TIMEOUT_TRY, NULL) == SUCCESS) {
+        len = sizeof(value);
+    }
+    if (ringbuffer_prio_read(&prio, &value, &len, SHORT_TIMEOUT, NULL) != RINGBUFFER_EMPTY ||
+        ringbuffer_prio_write(&prio, LANES, &value, sizeof(value), RB_TIMEOUT_TRY) != EINVAL) {
+        printf("Error: Test 3 failed. Empty ring or bad priority accepted\n");
+        exit(1);
+    }
+    pthread_t writer;
+    pthread_create(&writer, NULL, write_later, NULL);
+    unsigned priority;
+    len = sizeof(value);
+    if (ringbuffer_prio_read(&prio, &value, &len, RB_TIMEOUT_INFINITE, &priority) != SUCCESS ||
+        value != 42 || priority != 2) {
+        printf("Error: Test 3 failed. Blocked reader not woken\n");
+        exit(1);
+    }
+    pthread_join(writer, NULL);
+    printf("  + Test 3 passed\n");
+
+    ringbuffer_prio_destroy(&prio);
+    free(rbuf);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
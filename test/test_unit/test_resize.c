@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 256
+#define MAX_SIZE 4096
+#define MSG_LEN 40
+#define NUMBER_OF_MESSAGES 20000
+
+size_t resizes;
+size_t last_size;
+
+void on_resize(void *arg, size_t old_size, size_t new_size) {
+    (void) arg;
+    (void) old_size;
+    resizes++;
+    last_size = new_size;
+}
+
+/* message i: its number followed by a pattern derived from it */
+void make_msg(char *msg, int i) {
+    memcpy(msg, &i, sizeof(i));
+    for (int j = sizeof(i); j < MSG_LEN; j++) {
+        msg[j] = (char)(i + j);
+    }
+}
+
+int check_msg(const char *msg, size_t len, int i) {
+    char expected[MSG_LEN];
+    make_msg(expected, i);
+    return len == MSG_LEN && memcmp(msg, expected, MSG_LEN) == 0;
+}
+
+size_t ring_size(const rbctx_t *ctx) {
+    return ctx->end - ctx->begin;
+}
+
+void *produce(void *arg) {
+    rbctx_t *ctx = arg;
+    char msg[MSG_LEN];
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        make_msg(msg, i);
+        ringbuffer_write_timed(ctx, msg, MSG_LEN, RB_TIMEOUT_INFINITE);
+    }
+    return NULL;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[MSG_LEN];
+    char buffer[MSG_LEN];
+    rbstats_t stats;
+
+    rbresize_t policy;
+    ringbuffer_resize_init(&policy);
+    policy.max_size = MAX_SIZE;
+    policy.shrink_after = 4;
+    policy.on_resize = on_resize;
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * a full ring grows instead of failing, messages keep their order       *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: grow when full\n");
+    if (ringbuffer_init_resizable(ringbuffer_context, RBUF_SIZE, NULL, &policy) != SUCCESS) {
+        printf("Error: Test 1 failed. Could not initialize\n");
+        exit(1);
+    }
+    int written = 0, read = 0;
+    // move read and write to the middle first, so the ring wraps before it grows
+    for (; written < 3; written++) {
+        make_msg(msg, written);
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+    }
+    for (; read < 2; read++) {
+        size_t buffer_len = sizeof(buffer);
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+    }
+    for (;; written++) {
+        make_msg(msg, written);
+        if (ringbuffer_write_timed(ringbuffer_context, msg, MSG_LEN, RB_TIMEOUT_TRY) != SUCCESS) {
+            break;
+        }
+    }
+    ringbuffer_get_stats(ringbuffer_context, &stats);
+    if (ring_size(ringbuffer_context) != MAX_SIZE || last_size != MAX_SIZE || stats.grows != resizes ||
+        (size_t) (written - read) * (sizeof(size_t) + MSG_LEN) < MAX_SIZE / 2) {
+        printf("Error: Test 1 failed. size %zu after %zu resizes, %d messages\n",
+               ring_size(ringbuffer_context), resizes, written - read);
+        exit(1);
+    }
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * a draining ring shrinks back to min_size, messages keep their order   *
+     *************************************************************************/
+    printf("Test 2: shrink when idle\n");
+    for (; read < written; read++) {
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+            !check_msg(buffer, buffer_len, read)) {
+            printf("Error: Test 2 failed. Message %d lost or out of order\n", read);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < 32; i++) {
+        make_msg(msg, written);
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+        size_t buffer_len = sizeof(buffer);
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        if (!check_msg(buffer, buffer_len, written++)) {
+            printf("Error: Test 2 failed. Message %d corrupted\n", written - 1);
+            exit(1);
+        }
+    }
+    ringbuffer_get_stats(ringbuffer_context, &stats);
+    if (ring_size(ringbuffer_context) != RBUF_SIZE || stats.shrinks == 0 || last_size != RBUF_SIZE) {
+        printf("Error: Test 2 failed. size %zu after %lu shrinks\n",
+               ring_size(ringbuffer_context), (unsigned long) stats.shrinks);
+        exit(1);
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * explicit resizes respect the bounds and the messages in the ring      *
+     *************************************************************************/
+    printf("Test 3: explicit resize\n");
+    for (int i = 0; i < 4; i++) {
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+    }
+    if (ringbuffer_resize(ringbuffer_context, RBUF_SIZE / 2) != EINVAL ||
+        ringbuffer_resize(ringbuffer_context, MAX_SIZE * 2) != EINVAL ||
+        ringbuffer_resize(ringbuffer_context, MAX_SIZE) != SUCCESS || ring_size(ringbuffer_context) != MAX_SIZE) {
+        printf("Error: Test 3 failed. Bounds not applied\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    policy.min_size = 64;
+    ringbuffer_init_resizable(ringbuffer_context, RBUF_SIZE, NULL, &policy);
+    for (int i = 0; i < 4; i++) {
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+    }
+    if (ringbuffer_resize(ringbuffer_context, 64) != EBUSY) {
+        printf("Error: Test 3 failed. Shrunk below the messages in the ring\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    char rbuf[RBUF_SIZE];
+    ringbuffer_init(ringbuffer_context, rbuf, RBUF_SIZE);
+    if (ringbuffer_resize(ringbuffer_context, RBUF_SIZE * 2) != EINVAL) {
+        printf("Error: Test 3 failed. Resized a caller's buffer\n");
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * a ring that stays busy grows before it is full                        *
+     *************************************************************************/
+    printf("Test 4: grow when busy\n");
+    policy.min_size = 0;
+    policy.grow_at = 50;
+    policy.grow_after = 2;
+    ringbuffer_init_resizable(ringbuffer_context, RBUF_SIZE, NULL, &policy);
+    for (int i = 0; i < 4; i++) {
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN); // 4 * 48 of 256 bytes
+    }
+    ringbuffer_get_stats(ringbuffer_context, &stats);
+    if (ring_size(ringbuffer_context) != 2 * RBUF_SIZE || stats.grows != 1 || stats.full_timeouts != 0) {
+        printf("Error: Test 4 failed. size %zu\n", ring_size(ringbuffer_context));
+        exit(1);
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 4 passed\n");
+
+    /*************************************************************************
+     * TEST 5:                                                               *
+     * resizes under a concurrent writer and reader                          *
+     *************************************************************************/
+    printf("Test 5: concurrent resizes\n");
+    ringbuffer_resize_init(&policy);
+    policy.max_size = MAX_SIZE;
+    policy.shrink_after = 16;
+    ringbuffer_init_resizable(ringbuffer_context, RBUF_SIZE, NULL, &policy);
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, ringbuffer_context);
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_INFINITE) != SUCCESS ||
+            !check_msg(buffer, buffer_len, i)) {
+            printf("Error: Test 5 failed. Message %d lost or out of order\n", i);
+            exit(1);
+        }
+    }
+    pthread_join(producer, NULL);
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 5 passed\n");
+
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 1024
+#define NUMBER_OF_MESSAGES 2000
+
+/* attaches to name in a child process and runs fn there, returns the child's exit status */
+int in_child(const char *name, int (*fn)(rbctx_t *)) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("Error: fork failed\n");
+        exit(1);
+    }
+    if (pid == 0) {
+        rbctx_t ctx;
+        if (ringbuffer_attach_shared(&ctx, name) != SUCCESS) {
+            _exit(2);
+        }
+        _exit(fn(&ctx));
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int write_numbers(rbctx_t *ctx) {
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        if (ringbuffer_write_timed(ctx, &i, sizeof(i), RB_TIMEOUT_INFINITE) != SUCCESS) {
+            return 1;
+        }
+    }
+    ringbuffer_destroy(ctx);
+    return 0;
+}
+
+int die_holding_lock(rbctx_t *ctx) {
+    rbspan_t span;
+    if (ringbuffer_write_reserve(ctx, 4, &span) != SUCCESS) {
+        return 1;
+    }
+    ringbuffer_span_write(&span, 0, "dead", 4);
+    _exit(0); // never commits, never unlocks
+}
+
+int die_dropping(rbctx_t *ctx) {
+    rbspan_t span;
+    uint8_t junk[64];
+    memset(junk, 0xff, sizeof(junk));
+    if (ringbuffer_write_reserve(ctx, sizeof(junk), &span) != SUCCESS) {
+        return 1;
+    }
+    ringbuffer_span_write(&span, 0, junk, sizeof(junk)); // over the messages it dropped
+    _exit(0);
+}
+
+int main() {
+    char name[64];
+    snprintf(name, sizeof(name), "/ringbuf-test-%ld", (long) getpid());
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    rbctx_t *other = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL || other == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * two mappings of the same object see each other's messages             *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: create and attach\n");
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    attr.framing = RB_FRAME_U16;
+    ringbuffer_unlink_shared(name);
+    if (ringbuffer_create_shared(ringbuffer_context, name, RBUF_SIZE, &attr) != SUCCESS ||
+        ringbuffer_create_shared(other, name, RBUF_SIZE, &attr) != EEXIST ||
+        ringbuffer_attach_shared(other, "/ringbuf-test-missing") != ENOENT ||
+        ringbuffer_attach_shared(other, name) != SUCCESS) {
+        printf("Error: Test 1 failed. Could not create and attach %s\n", name);
+        exit(1);
+    }
+    if (other->begin == ringbuffer_context->begin || other->framing != RB_FRAME_U16 ||
+        other->end - other->begin != RBUF_SIZE) {
+        printf("Error: Test 1 failed. Attached ring does not match\n");
+        exit(1);
+    }
+    char msg[] = "shared message";
+    char buffer[64];
+    for (int i = 0; i < 200; i++) {
+        size_t buffer_len = sizeof(buffer);
+        rbctx_t *writer = (i % 2) ? ringbuffer_context : other;
+        rbctx_t *reader = (i % 2) ? other : ringbuffer_context;
+        if (ringbuffer_write(writer, msg, sizeof(msg)) != SUCCESS ||
+            ringbuffer_read(reader, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != sizeof(msg) || memcmp(buffer, msg, sizeof(msg)) != 0) {
+            printf("Error: Test 1 failed at message %d\n", i);
+            exit(1);
+        }
+    }
+    ringbuffer_destroy(other);
+    printf("  + Test 1 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * a child process writes, this process reads                            *
+     *************************************************************************/
+    printf("Test 2: producer in another process\n");
+    pid_t pid = fork();
+    if (pid == 0) {
+        rbctx_t ctx;
+        _exit(ringbuffer_attach_shared(&ctx, name) != SUCCESS ? 2 : write_numbers(&ctx));
+    }
+    for (int i = 0; i < NUMBER_OF_MESSAGES; i++) {
+        int value;
+        size_t len = sizeof(value);
+        if (ringbuffer_read_timed(ringbuffer_context, &value, &len, RB_TIMEOUT_INFINITE) != SUCCESS ||
+            len != sizeof(value) || value != i) {
+            printf("Error: Test 2 failed. Expected message %d\n", i);
+            exit(1);
+        }
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("Error: Test 2 failed. Producer failed\n");
+        exit(1);
+    }
+    printf("  + Test 2 passed\n");
+
+    /*************************************************************************
+     * TEST 3:                                                               *
+     * a process that dies holding the lock leaves a usable ring behind      *
+     *************************************************************************/
+    printf("Test 3: owner died\n");
+    if (in_child(name, die_holding_lock) != 0) {
+        printf("Error: Test 3 failed. Child could not reserve\n");
+        exit(1);
+    }
+    size_t buffer_len = sizeof(buffer);
+    if (ringbuffer_write(ringbuffer_context, msg, sizeof(msg)) != SUCCESS ||
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+        buffer_len != sizeof(msg) || memcmp(buffer, msg, sizeof(msg)) != 0 ||
+        ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY) != RINGBUFFER_EMPTY) {
+        printf("Error: Test 3 failed. Ring not usable after its owner died\n");
+        exit(1);
+    }
+    printf("  + Test 3 passed\n");
+
+    /*************************************************************************
+     * TEST 4:                                                               *
+     * a writer of an overwrite ring that dies after dropping messages       *
+     * leaves the messages it did not drop intact                            *
+     *************************************************************************/
+    printf("Test 4: owner died in an overwrite ring\n");
+    ringbuffer_destroy(ringbuffer_context);
+    ringbuffer_unlink_shared(name);
+    ringbuffer_attr_init(&attr);
+    attr.overwrite = 1;
+    if (ringbuffer_create_shared(ringbuffer_context, name, RBUF_SIZE, &attr) != SUCCESS) {
+        printf("Error: Test 4 failed. Could not create %s\n", name);
+        exit(1);
+    }
+    for (int i = 0; i < 1000; i++) {
+        ringbuffer_write(ringbuffer_context, &i, sizeof(i));
+    }
+    if (in_child(name, die_dropping) != 0) {
+        printf("Error: Test 4 failed. Child could not reserve\n");
+        exit(1);
+    }
+    uint64_t seq;
+    int value;
+    int last = -1;
+    buffer_len = sizeof(value);
+    while (ringbuffer_read_seq(ringbuffer_context, &value, &buffer_len, RB_TIMEOUT_TRY, &seq) == SUCCESS) {
+        if (buffer_len != sizeof(value) || seq != (uint64_t) value || value <= last) {
+            printf("Error: Test 4 failed. Message %d torn\n", last + 1);
+            exit(1);
+        }
+        last = value;
+        buffer_len = sizeof(value);
+    }
+    if (last != 999) {
+        printf("Error: Test 4 failed. Last message %d\n", last);
+        exit(1);
+    }
+    printf("  + Test 4 passed\n");
+
+    ringbuffer_destroy(ringbuffer_context);
+    if (ringbuffer_unlink_shared(name) != SUCCESS || ringbuffer_attach_shared(other, name) != ENOENT) {
+        printf("Error: unlink failed\n");
+        exit(1);
+    }
+    free(ringbuffer_context);
+    free(other);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
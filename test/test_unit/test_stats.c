@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+#define RBUF_SIZE 1024
+#define MSG_LEN 100
+#define SHORT_TIMEOUT 20000000 // 20 ms
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char* rbuf = malloc(RBUF_SIZE);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    char msg[MSG_LEN];
+    memset(msg, 'x', sizeof(msg));
+    char buffer[MSG_LEN];
+
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC, RB_MODE_MPMC};
+
+    for (int m = 0; m < 3; m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, RBUF_SIZE, &attr);
+        rbstats_t stats;
+
+        /*************************************************************************
+         * TEST 1:                                                               *
+         * messages and bytes are counted by every way in and out of the ring    *
+         *************************************************************************/
+        printf("--------------------------------------------------------\n");
+        printf("Test %d.1: message and byte counters\n", m + 1);
+        size_t n = 0;
+        while (ringbuffer_write_timed(ringbuffer_context, msg, MSG_LEN, RB_TIMEOUT_TRY) == SUCCESS) {
+            n++;
+        }
+        size_t buffer_len = sizeof(buffer);
+        ringbuffer_read(ringbuffer_context, buffer, &buffer_len);
+        rbspan_t span;
+        ringbuffer_read_peek(ringbuffer_context, &span);
+        ringbuffer_read_release(ringbuffer_context, &span);
+        struct iovec iov = {msg, 10};
+        ringbuffer_writev(ringbuffer_context, &iov, 1);
+        void *buffers[2] = {buffer, buffer};
+        size_t buffer_lens[2] = {MSG_LEN, MSG_LEN};
+        size_t count;
+        ringbuffer_read_batch(ringbuffer_context, buffers, buffer_lens, 1, 0, &count);
+
+        ringbuffer_get_stats(ringbuffer_context, &stats);
+        if (stats.messages_written != n + 1 || stats.bytes_written != n * MSG_LEN + 10 ||
+            stats.messages_read != 3 || stats.bytes_read != 3 * MSG_LEN || stats.full_timeouts != 1) {
+            printf("Error: Test %d.1 failed. written %lu/%lu, read %lu/%lu, full %lu\n", m + 1,
+                   (unsigned long) stats.messages_written, (unsigned long) stats.bytes_written,
+                   (unsigned long) stats.messages_read, (unsigned long) stats.bytes_read,
+                   (unsigned long) stats.full_timeouts);
+            exit(1);
+        }
+        printf("  + Test %d.1 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 2:                                                               *
+         * the high-water mark covers the full ring                              *
+         *************************************************************************/
+        printf("Test %d.2: high-water mark\n", m + 1);
+        size_t low = n * MSG_LEN;
+        if (stats.high_water < low || stats.high_water > RBUF_SIZE) {
+            printf("Error: Test %d.2 failed. high water %lu\n", m + 1, (unsigned long) stats.high_water);
+            exit(1);
+        }
+        printf("  + Test %d.2 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 3:                                                               *
+         * failed calls and the time spent waiting are counted                   *
+         *************************************************************************/
+        printf("Test %d.3: timeouts and wait time\n", m + 1);
+        do {
+            buffer_len = sizeof(buffer);
+        } while (ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, RB_TIMEOUT_TRY) == SUCCESS);
+        buffer_len = sizeof(buffer);
+        ringbuffer_read_timed(ringbuffer_context, buffer, &buffer_len, SHORT_TIMEOUT);
+        // last, the locked ring does not keep a message that did not fit
+        buffer_len = 1;
+        ringbuffer_write(ringbuffer_context, msg, MSG_LEN);
+        if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != OUTPUT_BUFFER_TOO_SMALL) {
+            printf("Error: Test %d.3 failed. Small buffer accepted\n", m + 1);
+            exit(1);
+        }
+
+        ringbuffer_get_stats(ringbuffer_context, &stats);
+        if (stats.too_small != 1 || stats.empty_timeouts != 2 ||
+            stats.read_wait_ns < SHORT_TIMEOUT || stats.write_wait_ns != 0) {
+            printf("Error: Test %d.3 failed. too small %lu, empty %lu, waited %lu/%lu ns\n", m + 1,
+                   (unsigned long) stats.too_small, (unsigned long) stats.empty_timeouts,
+                   (unsigned long) stats.read_wait_ns, (unsigned long) stats.write_wait_ns);
+            exit(1);
+        }
+        printf("  + Test %d.3 passed\n", m + 1);
+
+        /*************************************************************************
+         * TEST 4:                                                               *
+         * reset clears every counter                                            *
+         *************************************************************************/
+        printf("Test %d.4: reset\n", m + 1);
+        ringbuffer_reset_stats(ringbuffer_context);
+        ringbuffer_get_stats(ringbuffer_context, &stats);
+        rbstats_t zero = {0};
+        if (memcmp(&stats, &zero, sizeof(stats)) != 0) {
+            printf("Error: Test %d.4 failed. Counters not cleared\n", m + 1);
+            exit(1);
+        }
+        printf("  + Test %d.4 passed\n", m + 1);
+
+        ringbuffer_destroy(ringbuffer_context);
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}
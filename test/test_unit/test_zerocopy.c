@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/ringbuf.h"
+
+/* fills a reservation in place, commits it and checks that a normal read returns it */
+int reserve_commit_read(rbctx_t *ctx, char *msg, size_t msg_len, int expect_split) {
+    rbspan_t span;
+    if (ringbuffer_write_reserve(ctx, msg_len, &span) != SUCCESS) {
+        printf("Error: reserve failed\n");
+        return 1;
+    }
+    if (expect_split != (span.ptr[1] != NULL)) {
+        printf("Error: expected the reservation to be %s\n", expect_split ? "split" : "contiguous");
+        return 1;
+    }
+    if (ringbuffer_span_write(&span, 0, msg, msg_len) != msg_len) {
+        printf("Error: span write copied too little\n");
+        return 1;
+    }
+    if (ringbuffer_write_commit(ctx, &span, msg_len) != SUCCESS) {
+        printf("Error: commit failed\n");
+        return 1;
+    }
+
+    char buffer[100];
+    size_t buffer_len = sizeof(buffer);
+    if (ringbuffer_read(ctx, buffer, &buffer_len) != SUCCESS || buffer_len != msg_len ||
+        memcmp(buffer, msg, msg_len) != 0) {
+        printf("Error: committed message not read back\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* writes a message normally and checks that peek exposes it in place */
+int write_peek_release(rbctx_t *ctx, char *msg, size_t msg_len) {
+    if (ringbuffer_write(ctx, msg, msg_len) != SUCCESS) {
+        printf("Error: write failed\n");
+        return 1;
+    }
+
+    rbspan_t span;
+    if (ringbuffer_read_peek(ctx, &span) != SUCCESS) {
+        printf("Error: peek failed\n");
+        return 1;
+    }
+    char buffer[100];
+    if (span.len[0] + span.len[1] != msg_len ||
+        ringbuffer_span_read(&span, 0, buffer, msg_len) != msg_len ||
+        memcmp(buffer, msg, msg_len) != 0) {
+        printf("Error: peeked message does not match\n");
+        return 1;
+    }
+    ringbuffer_read_release(ctx, &span);
+    return 0;
+}
+
+int main() {
+    rbctx_t *ringbuffer_context = malloc(sizeof(rbctx_t));
+    if (ringbuffer_context == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+
+    char msg[] = "zero copy msg";
+    size_t msg_len = strlen(msg) + 1;
+    // second frame wraps, also in the 32 byte power of two RB_MODE_SPSC uses
+    size_t rbuf_size = 2 * (msg_len + sizeof(size_t)) - 5;
+    char* rbuf = malloc(rbuf_size);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    rbattr_t attr;
+    ringbuffer_attr_init(&attr);
+
+    /*************************************************************************
+     * TEST 1:                                                               *
+     * reserve/commit and peek/release in every mode                         *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 1: reserve/commit and peek/release\n");
+
+    rbmode_t modes[] = {RB_MODE_LOCKED, RB_MODE_SPSC};
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        attr.mode = modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, rbuf_size, &attr);
+
+        /* first frame fits before the end, the second one wraps */
+        if (reserve_commit_read(ringbuffer_context, msg, msg_len, 0) != 0 ||
+            reserve_commit_read(ringbuffer_context, msg, msg_len, 1) != 0) {
+            printf("Error: Test 1.%zu failed\n", m + 1);
+            exit(1);
+        }
+        for (int i = 0; i < 5; i++) {
+            if (write_peek_release(ringbuffer_context, msg, msg_len) != 0) {
+                printf("Error: Test 1.%zu failed\n", m + 1);
+                exit(1);
+            }
+        }
+        ringbuffer_destroy(ringbuffer_context);
+        printf("  + Test 1.%zu passed\n", m + 1);
+    }
+
+    free(rbuf);
+    rbuf_size = 512;
+    rbuf = malloc(rbuf_size);
+    if (rbuf == NULL) {
+        printf("Error: malloc failed\n");
+        exit(1);
+    }
+    attr.mode = RB_MODE_MPMC;
+    attr.slot_size = 64;
+    ringbuffer_init_attr(ringbuffer_context, rbuf, rbuf_size, &attr);
+    for (int i = 0; i < 10; i++) {
+        if (reserve_commit_read(ringbuffer_context, msg, msg_len, 0) != 0 ||
+            write_peek_release(ringbuffer_context, msg, msg_len) != 0) {
+            printf("Error: Test 1.3 failed\n");
+            exit(1);
+        }
+    }
+    ringbuffer_destroy(ringbuffer_context);
+    printf("  + Test 1.3 passed\n");
+
+    /*************************************************************************
+     * TEST 2:                                                               *
+     * committing less than reserved and canceling                           *
+     *************************************************************************/
+    printf("--------------------------------------------------------\n");
+    printf("Test 2: partial commit and cancel\n");
+
+    for (int m = 0; m < 3; m++) {
+        attr.mode = m == 2 ? RB_MODE_MPMC : modes[m];
+        ringbuffer_init_attr(ringbuffer_context, rbuf, rbuf_size, &attr);
+
+        rbspan_t span;
+        if (ringbuffer_write_reserve(ringbuffer_context, 60, &span) != SUCCESS) {
+            printf("Error: Test 2.%d failed. Reserve failed\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_write_cancel(ringbuffer_context, &span);
+
+        if (ringbuffer_write_reserve(ringbuffer_context, 60, &span) != SUCCESS) {
+            printf("Error: Test 2.%d failed. Reserve after cancel failed\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_span_write(&span, 0, msg, msg_len);
+        ringbuffer_write_commit(ringbuffer_context, &span, msg_len);
+
+        char buffer[100];
+        size_t buffer_len = sizeof(buffer);
+        if (ringbuffer_read(ringbuffer_context, buffer, &buffer_len) != SUCCESS ||
+            buffer_len != msg_len || strcmp(buffer, msg) != 0) {
+            printf("Error: Test 2.%d failed. Expected only the committed message\n", m + 1);
+            exit(1);
+        }
+        ringbuffer_destroy(ringbuffer_context);
+        printf("  + Test 2.%d passed\n", m + 1);
+    }
+
+    free(rbuf);
+    free(ringbuffer_context);
+
+    printf("--------------------------------------------------------\n");
+    printf("All tests passed\n");
+}